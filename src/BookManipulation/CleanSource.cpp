@@ -25,6 +25,8 @@
 #include <QtCore/QString>
 #include <QtCore/QStringList>
 #include <QtCore/QWriteLocker>
+#include <QtCore/QXmlStreamReader>
+#include <QtConcurrent/QtConcurrent>
 #include <QtWidgets/QApplication>
 #include <QtWidgets/QProgressDialog>
 #include <QRegularExpression>
@@ -37,6 +39,7 @@
 #include "sigil_constants.h"
 #include "sigil_exception.h"
 #include "Misc/Utility.h"
+#include <functional>
 #include <utility>
 
 static const QString HEAD_END = "</\\s*head\\s*>";
@@ -129,6 +132,10 @@ QString CleanSource::ToValidXHTML(const QString &source, const QString &version)
 XhtmlDoc::WellFormedError CleanSource::WellFormedXMLCheck(const QString &source, const QString mtype)
 {
     XhtmlDoc::WellFormedError error; 
+    if (NativeWellFormedXMLCheck(source, error)) {
+        return error;
+    }
+    // documents with entities are left to lxml
     int rv = 0;
     QString error_traceback;
     QList<QVariant> args;
@@ -142,9 +149,11 @@ XhtmlDoc::WellFormedError CleanSource::WellFormedXMLCheck(const QString &source,
                                          &rv,
                                          error_traceback);    
     if (rv != 0) {
-        Utility::DisplayStdWarningDialog(QString("error in xmlprocessor WellFormedXMLCheck: ") + QString::number(rv), 
-                                         error_traceback);
         // an error happened during check, return well-formed as true
+        // and leave showing the failure to the caller on the GUI thread
+        error = XhtmlDoc::WellFormedError();
+        error.message = QString("error in xmlprocessor WellFormedXMLCheck: ") + QString::number(rv) +
+                        "\n" + error_traceback;
         return error;
     }
     QStringList errors = res.toStringList();
@@ -154,34 +163,82 @@ XhtmlDoc::WellFormedError CleanSource::WellFormedXMLCheck(const QString &source,
     return error;
 }
 
+void CleanSource::ShowWellFormedCheckFailure(const XhtmlDoc::WellFormedError &error)
+{
+    if ((error.line != -1) || error.message.isEmpty()) {
+        return;
+    }
+    Utility::DisplayStdWarningDialog(error.message.section('\n', 0, 0),
+                                     error.message.section('\n', 1));
+}
+
 bool CleanSource::IsWellFormedXML(const QString &source, const QString mtype)
 {
-    int rv = 0;
-    QString error_traceback;
-    QList<QVariant> args;
-    args.append(QVariant(source));
-    args.append(QVariant(mtype));
-    EmbeddedPython * epython  = EmbeddedPython::instance();
+    XhtmlDoc::WellFormedError error = WellFormedXMLCheck(source, mtype);
+    ShowWellFormedCheckFailure(error);
+    return error.line == -1;
+}
 
-    QVariant res = epython->runInPython( QString("xmlprocessor"),
-                                         QString("IsWellFormedXML"),
-                                         args,
-                                         &rv,
-                                         error_traceback);    
-    if (rv != 0) {
-        Utility::DisplayStdWarningDialog(QString("error in xmlprocessor IsWellFormedXML: ") + QString::number(rv), 
-                                         error_traceback);
-        // an error happened during check return well-formed as true
-        return true;
-    }
-    return res.toBool();
+QList<XhtmlDoc::WellFormedError> CleanSource::WellFormedXMLCheckAll(const QStringList &sources, const QString mtype)
+{
+    return QtConcurrent::blockingMapped<QList<XhtmlDoc::WellFormedError> >(sources,
+               std::bind(&CleanSource::WellFormedXMLCheck, std::placeholders::_1, mtype));
 }
 
 QString CleanSource::ProcessXML(const QString &source, const QString mtype)
 {
+    // Almost everything passed in here is already well formed and python
+    // would hand it back unchanged, so only go to python when it needs repair.
+    // TODO: native repair and pretty printing matching repairXML byte for
+    // byte, python would then only be the fallback.
+    if (IsUnchangedByRepairXML(source)) {
+        return source;
+    }
     return XMLPrettyPrintBS4(source, mtype);
 }
 
+
+bool CleanSource::IsUnchangedByRepairXML(const QString &source)
+{
+    XhtmlDoc::WellFormedError error;
+    return NativeWellFormedXMLCheck(source, error) && (error.line == -1);
+}
+
+
+bool CleanSource::NativeWellFormedXMLCheck(const QString &source, XhtmlDoc::WellFormedError &error)
+{
+    // Same as _remove_xml_header in xmlprocessor.py, python reports
+    // line numbers relative to the source without the header as well
+    static const QRegularExpression xml_header("<\\s*\\?xml\\s*[^\\?>]*\\?*>\\s*",
+                                               QRegularExpression::CaseInsensitiveOption);
+    QString data = source;
+    QRegularExpressionMatch mo = xml_header.match(data);
+    if (mo.hasMatch()) {
+        data.remove(mo.capturedStart(), mo.capturedLength());
+    }
+
+    QXmlStreamReader reader(data);
+    while (!reader.atEnd()) {
+        QXmlStreamReader::TokenType token = reader.readNext();
+        // lxml leaves entities unresolved and the two parsers do not agree on
+        // what an undeclared entity means, so leave those to python.
+        if (token == QXmlStreamReader::EntityReference) {
+            return false;
+        }
+        if (token == QXmlStreamReader::DTD && !reader.entityDeclarations().isEmpty()) {
+            return false;
+        }
+    }
+    error = XhtmlDoc::WellFormedError();
+    if (reader.hasError()) {
+        error.line    = reader.lineNumber();
+        // libxml2 counts columns from 1
+        error.column  = reader.columnNumber() + 1;
+        error.message = reader.errorString();
+    }
+    return true;
+}
+
 QString CleanSource::RemoveMetaCharset(const QString &source)
 {
     int head_end = source.indexOf(QRegularExpression(HEAD_END));
@@ -43,10 +43,30 @@ public:
 
     static QString ProcessXML(const QString &source, const QString mtype="");
 
+    /**
+     * Safe to call from any thread, it never shows a dialog.
+     * When the python check itself fails the error has no line and
+     * its message holds the failure, see ShowWellFormedCheckFailure.
+     */
     static XhtmlDoc::WellFormedError WellFormedXMLCheck(const QString &source, const QString mtype="");
 
+    /**
+     * Shows the python failure carried by an error from WellFormedXMLCheck.
+     * Does nothing for other errors. Must be called on the GUI thread.
+     */
+    static void ShowWellFormedCheckFailure(const XhtmlDoc::WellFormedError &error);
+
+    /**
+     * Shows a python failure itself, so only call it on the GUI thread.
+     */
     static bool IsWellFormedXML(const QString &source, const QString mtype="");
 
+    /**
+     * Runs WellFormedXMLCheck on all sources in parallel.
+     * The errors are returned in the order of the sources.
+     */
+    static QList<XhtmlDoc::WellFormedError> WellFormedXMLCheckAll(const QStringList &sources, const QString mtype="");
+
     static QString MendPrettify(const QString &source, const QString &version);
 
     static QString XMLPrettyPrintBS4(const QString &source, const QString mtype="");
@@ -78,6 +98,29 @@ private:
      */
     static QString RemoveMetaCharset(const QString &source);
 
+    /**
+     * Checks if xml would be left unchanged by xmlprocessor.repairXML
+     * without calling into python. repairXML returns its input as is
+     * when lxml can parse it once the xml declaration is removed.
+     *
+     * This check may reject documents lxml accepts (entity references
+     * and DTD entity declarations are always rejected) but never
+     * accepts one lxml rejects, so a false result only means the
+     * python repair has to run.
+     */
+    static bool IsUnchangedByRepairXML(const QString &source);
+
+    /**
+     * Checks xml for well-formedness with QXmlStreamReader the way
+     * xmlprocessor.WellFormedXMLCheck does with lxml: the xml declaration
+     * is removed first and line and column of the first error are reported.
+     *
+     * @return \c false if the source has entity references or
+     *         declarations and needs lxml to decide, error is
+     *         not set then.
+     */
+    static bool NativeWellFormedXMLCheck(const QString &source, XhtmlDoc::WellFormedError &error);
+
 };
 
 
@@ -128,7 +128,8 @@ Resource *FolderKeeper::AddContentFileToFolder(const QString &fullfilepath,
 					       bool update_opf, 
 					       const QString &mimetype, 
 					       const QString &bookpath,
-					       const QString &folderpath)
+					       const QString &folderpath,
+					       bool move_file)
 {
     if (!QFileInfo(fullfilepath).exists()) {
         throw(FileDoesNotExist(fullfilepath.toStdString()));
@@ -237,7 +238,11 @@ Resource *FolderKeeper::AddContentFileToFolder(const QString &fullfilepath,
         resource->SetShortPathName(filename);
     }
 
-    QFile::copy(fullfilepath, new_file_path);
+    // Moving is a rename when both folders are on the same volume
+    // so the file is not written a second time.
+    if (!move_file || !Utility::RenameFile(fullfilepath, new_file_path)) {
+        QFile::copy(fullfilepath, new_file_path);
+    }
 
     if (QThread::currentThread() != QApplication::instance()->thread()) {
         resource->moveToThread(QApplication::instance()->thread());
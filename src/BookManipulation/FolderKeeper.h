@@ -88,13 +88,17 @@ public:
      * @param mimetype   The mimetype for the associated file.
      * @param bookpath   The ebook root file relative href
      * @param folderpath The ebook root folder relative href
+     * @param move_file  If set to \c true, the file is moved into the book
+     *                   folder instead of being copied. Only for files
+     *                   nothing else needs, such as freshly extracted ones.
      * @return The newly created resource.
      */
     Resource *AddContentFileToFolder(const QString &fullfilepath,
                                      bool update_opf = true,
                                      const QString &mimetype = QString(),
 				     const QString &bookpath = QString(),
-				     const QString &folderpath = QString("\\"));
+				     const QString &folderpath = QString("\\"),
+				     bool move_file = false);
 
     /**
      * Returns the highest reading order number present in the book.
@@ -27,7 +27,6 @@
 #include <QtConcurrent/QtConcurrent>
 #include <QtWidgets/QApplication>
 #include <QtWidgets/QProgressDialog>
-#include <QRegularExpression>
 
 #include "ResourceObjects/HTMLResource.h"
 #include "Misc/GumboInterface.h"
@@ -35,6 +34,7 @@
 #include "MiscEditors/IndexEditorModel.h"
 #include "BookManipulation/Index.h"
 #include "MiscEditors/IndexEntries.h"
+#include "PCRE/PCRECache.h"
 #include "sigil_constants.h"
 
 const QString SIGIL_INDEX_CLASS = "sigil_index_marker";
@@ -154,9 +154,8 @@ bool Index::CreateIndexEntry(const QString text, HTMLResource *html_resource, QS
             continue;
         }
 
-        QRegularExpression index_regex(index_pattern);
-
-        if (text.contains(index_regex)) {
+        // Only need to know if there is a match at all so stop at the first one.
+        if (PCRECache::instance()->getObject(index_pattern)->hasMatch(text)) {
             created_index = true;
             QString index_entry = entry->index_entry;
             if (index_entry.isEmpty()) {
@@ -32,7 +32,7 @@
 #include "MainUI/MainWindow.h"
 #include "Misc/Language.h"
 #include "Misc/SettingsStore.h"
-#include "Misc/PythonRoutines.h"
+#include "ResourceObjects/MetadataProcessor.h"
 
 static const QString SETTINGS_GROUP = "meta_editor";
 
@@ -102,8 +102,7 @@ MetaEditor::~MetaEditor()
 
 
 QString MetaEditor::GetOPFMetadata() {
-    PythonRoutines pr;
-    MetadataPieces mdp = pr.GetMetadataInPython(m_opfdata, m_version);
+    MetadataPieces mdp = m_book->GetConstOPF()->GetMetadataPieces();
     QString data = mdp.data;
     m_otherxml = mdp.otherxml;
     m_metatag = mdp.metatag;
@@ -120,8 +119,7 @@ QString MetaEditor::SetNewOPFMetadata(QString& data)
     mdp.otherxml = m_otherxml;
     mdp.metatag = m_metatag;
     mdp.idlist = m_idlist;
-    PythonRoutines pr;
-    QString results = pr.SetNewMetadataInPython(mdp, m_opfdata, m_version);
+    QString results = MetadataProcessor::SetNewMetadata(mdp, m_opfdata, m_version);
     if (!results.isEmpty()) {
         newopfdata = results;
     }
@@ -731,17 +731,29 @@ bool PluginRunner::checkIsWellFormed()
         }
     }
     if (!xmlFilesToCheck.isEmpty()) {
+        // can't really validate without a full dtd so
+        // auto repair any xml file changes to be safe
+        ui.statusLbl->setText(tr("Status: checking") + " " + tr("XML files"));
+        QStringList xmlData;
         foreach (QString href, xmlFilesToCheck) {
-            // can't really validate without a full dtd so
-            // auto repair any xml file changes to be safe
+            xmlData << Utility::ReadUnicodeTextFile(m_outputDir + "/" + href);
+        }
+        // repair leaves well-formed files unchanged so check them all at once
+        // and only repair the ones that need it
+        QList<XhtmlDoc::WellFormedError> xmlErrors = CleanSource::WellFormedXMLCheckAll(xmlData);
+        for (int i = 0; i < xmlFilesToCheck.count(); ++i) {
+            CleanSource::ShowWellFormedCheckFailure(xmlErrors.at(i));
+            if (xmlErrors.at(i).line == -1) {
+                continue;
+            }
+            QString href = xmlFilesToCheck.at(i);
             QString filePath = m_outputDir + "/" + href;
             ui.statusLbl->setText(tr("Status: checking") + " " + href);
             QString mtype = "application/oebs-page-map+xml";
             if (href.endsWith(".opf")) mtype = "application/oebps-package+xml";
             if (href.endsWith(".ncx")) mtype = "application/x-dtbncx+xml";
             if (href.endsWith(".smil")) mtype = "application/oebps-package+xml";
-            QString data = Utility::ReadUnicodeTextFile(filePath);
-            QString newdata = CleanSource::ProcessXML(data, mtype);
+            QString newdata = CleanSource::ProcessXML(xmlData.at(i), mtype);
             Utility::WriteUnicodeTextFile(newdata, filePath);
         }
     }
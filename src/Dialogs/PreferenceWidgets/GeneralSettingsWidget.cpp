@@ -31,6 +31,8 @@
 #include <QStandardPaths>
 
 #include "Misc/Utility.h"
+#include "PCRE/PCRECache.h"
+#include "PCRE/SPCRE.h"
 #include "sigil_constants.h"
 
 GeneralSettingsWidget::GeneralSettingsWidget()
@@ -75,6 +77,14 @@ PreferencesWidget::ResultAction GeneralSettingsWidget::saveSettings()
         css_epub3_spec = "css21";
     }
 
+    QString export_compression = "balanced";
+
+    if (ui.CompressionFast->isChecked()) {
+        export_compression = "fast";
+    } else if (ui.CompressionSmallest->isChecked()) {
+        export_compression = "smallest";
+    }
+
     int new_remote_on_level = 0;
 
     if (ui.AllowRemote->isChecked()) {
@@ -110,6 +120,9 @@ PreferencesWidget::ResultAction GeneralSettingsWidget::saveSettings()
     settings.setClipboardHistoryLimit(int(ui.clipLimitSpin->value()));
     settings.setTempFolderHome(new_temp_folder_home);
     settings.setExternalXEditorPath(new_xeditor_path);
+    settings.setExportCompression(export_compression);
+    settings.setRegexJIT(ui.RegexJIT->isChecked());
+    PCRECache::instance()->setUseJIT(ui.RegexJIT->isChecked());
 
     if (!m_refreshClipboardHistoryLimit) {
         return PreferencesWidget::ResultAction_None;
@@ -143,6 +156,12 @@ void GeneralSettingsWidget::readSettings()
     ui.lineEdit->setText(temp_folder_home);
     QString xeditor_path = settings.externalXEditorPath();
     ui.lineEdit7->setText(xeditor_path);
+    QString export_compression = settings.exportCompression();
+    ui.CompressionFast->setChecked(export_compression == "fast");
+    ui.CompressionBalanced->setChecked(export_compression == "balanced");
+    ui.CompressionSmallest->setChecked(export_compression == "smallest");
+    ui.RegexJIT->setChecked(settings.regexJIT());
+    ui.RegexJIT->setEnabled(SPCRE::isJITAvailable());
 }
 
 void GeneralSettingsWidget::clearXEditorPath()
@@ -27,17 +27,24 @@
 #include <string>
 #include <string.h>
 #include <zip.h>
+#include <zlib.h>
 #ifdef _WIN32
 #include <iowin32.h>
 #endif
 
+#include <QtCore/QBuffer>
 #include <QtCore/QDateTime>
 #include <QtCore/QDir>
 #include <QtCore/QDirIterator>
+#include <QtCore/QElapsedTimer>
 #include <QtCore/QFile>
 #include <QtCore/QFileInfo>
-#include <QtCore/QTemporaryFile>
+#include <QtCore/QHash>
+#include <QtCore/QStringList>
 #include <QtCore/QTextStream>
+#include <QtCore/QThreadPool>
+#include <QtConcurrent/QtConcurrent>
+#include <QDebug>
 
 #include "BookManipulation/CleanSource.h"
 #include "BookManipulation/FolderKeeper.h"
@@ -47,11 +54,14 @@
 #include "Misc/Utility.h"
 #include "Misc/TempFolder.h"
 #include "Misc/FontObfuscation.h"
+#include "Misc/MediaTypes.h"
+#include "Misc/SettingsStore.h"
 #include "ResourceObjects/FontResource.h"
+#include "ResourceObjects/TextResource.h"
 #include "sigil_constants.h"
 #include "sigil_exception.h"
 
-#define BUFF_SIZE 8192
+#define BUFF_SIZE 65536
 
 const QString BODY_START = "<\\s*body[^>]*>";
 const QString BODY_END   = "</\\s*body\\s*>";
@@ -59,10 +69,246 @@ const QString BODY_END   = "</\\s*body\\s*>";
 const QString CONTAINER_XML_FILE_NAME  = "container.xml";
 const QString ENCRYPTION_XML_FILE_NAME = "encryption.xml";
 
-static const QString METAINF_FOLDER_SUFFIX = "/META-INF";
+// What was stored and how well the rest compressed on the last save
+static const QString EXPORT_REPORT_FILE_NAME = "export_report.txt";
+
+static const QString METAINF_FOLDER = "META-INF";
 
 static const char * EPUB_MIME_DATA = "application/epub+zip";
 
+// Entries are compressed in chunks of this size
+static const qint64 DEFLATE_CHUNK_SIZE = 1024 * 1024;
+
+// How much input is handed to the thread pool at a time
+static const qint64 DEFLATE_BATCH_SIZE = 64 * 1024 * 1024;
+
+// The deflate window, a chunk is primed with this much of the input before it
+static const qint64 DEFLATE_DICT_SIZE = 32 * 1024;
+
+// Media types whose data is compressed already; deflating
+// them costs a lot of time for next to no gain so they are stored
+static const QStringList STORED_MEDIATYPES = QStringList() << "image/jpeg" << "image/png" << "image/gif"
+                                                           << "image/webp" << "application/font-woff"
+                                                           << "application/font-woff2" << "font/woff"
+                                                           << "font/woff2" << "audio/mpeg" << "audio/mp3"
+                                                           << "audio/mp4" << "audio/ogg" << "video/mp4"
+                                                           << "video/ogg" << "video/webm";
+
+// OpenType fonts are stored too when their outlines are CFF data
+static const QStringList OPENTYPE_MEDIATYPES = QStringList() << "font/otf" << "application/vnd.ms-opentype"
+                                                             << "application/x-font-opentype"
+                                                             << "application/font-sfnt";
+
+// The deflate level of the compression profiles in the preferences
+static const QHash<QString, int> PROFILE_LEVELS = {
+    { "fast",     1 },
+    { "balanced", 6 },
+    { "smallest", 9 },
+};
+
+
+// A piece of an entry to be compressed
+struct CompressChunk {
+    // The index of the entry the chunk is part of
+    int entry;
+
+    // The deflate level, 0 stores the chunk as it is
+    int level;
+
+    // The content of the entry when it is in memory,
+    // otherwise the file to read the chunk from
+    bool from_memory;
+    QByteArray data;
+    QString fullpath;
+
+    // The part of the entry content the chunk covers
+    qint64 offset;
+    qint64 length;
+    bool first;
+    bool last;
+
+    // Font obfuscation to apply while reading
+    QString algorithm;
+    QByteArray key;
+};
+
+// A chunk as it goes into the archive
+struct CompressedChunk {
+    QByteArray compressed;
+    uLong crc;
+    qint64 nsecs;
+    bool ok;
+};
+
+
+// Returns the deflate level for an entry of the media type,
+// 0 if it should be stored
+static int CompressionLevel(const QString &mediatype, const QString &fullpath, int profile_level)
+{
+    if (STORED_MEDIATYPES.contains(mediatype)) {
+        return 0;
+    }
+
+    if (OPENTYPE_MEDIATYPES.contains(mediatype)) {
+        QFile font(fullpath);
+
+        if (font.open(QIODevice::ReadOnly) && font.read(4) == "OTTO") {
+            return 0;
+        }
+    }
+
+    return profile_level;
+}
+
+
+// Returns the end of the batch of chunks that starts at start
+static int NextBatchEnd(const QList<CompressChunk> &chunks, int start)
+{
+    int end = start;
+    qint64 batch_size = 0;
+
+    while (end < chunks.count() && (end == start || batch_size < DEFLATE_BATCH_SIZE)) {
+        batch_size += chunks.at(end).length;
+        end++;
+    }
+
+    return end;
+}
+
+
+static CompressedChunk CompressOneChunk(const CompressChunk &chunk)
+{
+    QElapsedTimer timer;
+    timer.start();
+    CompressedChunk result;
+    result.ok = false;
+    result.crc = 0;
+    result.nsecs = 0;
+
+    // Read the chunk together with the input before it
+    // that goes into the deflate window
+    qint64 dict_start = chunk.level == 0 ? chunk.offset : qMax(Q_INT64_C(0), chunk.offset - DEFLATE_DICT_SIZE);
+    qint64 read_size = chunk.offset + chunk.length - dict_start;
+    QByteArray input;
+
+    if (chunk.from_memory) {
+        input = chunk.data.mid((int)dict_start, (int)read_size);
+    } else {
+        QFile dfile(chunk.fullpath);
+
+        if (!dfile.open(QIODevice::ReadOnly) || !dfile.seek(dict_start)) {
+            return result;
+        }
+
+        input = dfile.read(read_size);
+    }
+
+    if (input.size() != read_size) {
+        return result;
+    }
+
+    if (!chunk.algorithm.isEmpty()) {
+        FontObfuscation::ObfuscateBlock(input.data(), input.size(), dict_start, chunk.algorithm, chunk.key);
+    }
+
+    int dict_size = (int)(chunk.offset - dict_start);
+
+    if (chunk.level == 0) {
+        result.compressed = input;
+        result.crc = crc32(0L, (const Bytef *)input.constData(), (uInt)chunk.length);
+        result.nsecs = timer.nsecsElapsed();
+        result.ok = true;
+        return result;
+    }
+
+    z_stream stream;
+    memset(&stream, 0, sizeof(stream));
+
+    if (deflateInit2(&stream, chunk.level, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+        return result;
+    }
+
+    if (dict_size > 0) {
+        deflateSetDictionary(&stream, (const Bytef *)input.constData(), dict_size);
+    }
+
+    // A sync flush adds at most an empty stored block to the bound
+    result.compressed.resize((int)deflateBound(&stream, (uLong)chunk.length) + 16);
+    stream.next_in = (Bytef *)input.data() + dict_size;
+    stream.avail_in = (uInt)chunk.length;
+    int flush = chunk.last ? Z_FINISH : Z_SYNC_FLUSH;
+    int err;
+
+    // A flush is only complete once deflate leaves room in the output,
+    // otherwise part of the flushed output is still held in the stream
+    while (true) {
+        stream.next_out = (Bytef *)result.compressed.data() + stream.total_out;
+        stream.avail_out = (uInt)(result.compressed.size() - (int)stream.total_out);
+        err = deflate(&stream, flush);
+
+        if (err == Z_STREAM_END || (err != Z_OK && err != Z_BUF_ERROR) || stream.avail_out != 0) {
+            break;
+        }
+
+        result.compressed.resize(result.compressed.size() * 2);
+    }
+
+    result.compressed.resize((int)stream.total_out);
+    deflateEnd(&stream);
+
+    if ((chunk.last && err != Z_STREAM_END) || (!chunk.last && err != Z_OK) || stream.avail_in != 0) {
+        return result;
+    }
+
+    result.crc = crc32(0L, (const Bytef *)input.constData() + dict_size, (uInt)chunk.length);
+    result.nsecs = timer.nsecsElapsed();
+    result.ok = true;
+    return result;
+}
+
+
+// The bytes Utility::WriteUnicodeTextFile would put on disk for text,
+// so the epub gets the same line endings as when it was zipped from disk
+static QByteArray TextFileContents(const QString &text)
+{
+#if defined(Q_OS_WIN32)
+    QString crlf_text(text);
+    return crlf_text.replace("\n", "\r\n").toUtf8();
+#else
+    return text.toUtf8();
+#endif
+}
+
+
+// Overwrites the contents of the real file with the contents of the
+// finished one. Used when the finished file can not simply be renamed
+// into place; it also keeps extended attributes such as labels on OS X.
+static bool CopyFileContents(const QString &fullinpath, const QString &fulloutpath)
+{
+    QFile in_file(fullinpath);
+
+    if (!in_file.open(QFile::ReadOnly)) {
+        return false;
+    }
+
+    QFile out_file(fulloutpath);
+
+    if (!out_file.open(QFile::WriteOnly | QFile::Truncate)) {
+        return false;
+    }
+
+    QByteArray buff(BUFF_SIZE, 0);
+    qint64 read = 0;
+
+    while ((read = in_file.read(buff.data(), BUFF_SIZE)) > 0) {
+        if (out_file.write(buff.constData(), read) != read) {
+            return false;
+        }
+    }
+
+    return read == 0;
+}
+
 
 // Constructor;
 // the first parameter is the location where the book
@@ -93,43 +339,127 @@ void ExportEPUB::WriteBook()
     m_Book->GetOPF()->AddSigilVersionMeta();
     m_Book->GetOPF()->AddModificationDateMeta();
     m_Book->SaveAllResourcesToDisk();
-    TempFolder tempfolder;
-    CreatePublication(tempfolder.GetPath());
+    QList<ExportEntry> entries = GetExportEntries();
+
+    // Write next to the target and rename the finished epub into
+    // place, so an interrupted save never leaves a broken target.
+    // Targets that can not be renamed over are overwritten in place.
+    QFileInfo target(m_FullFilePath);
+    if (QFileInfo(target.absolutePath()).isWritable()) {
+        QString tempFile = target.absolutePath() + "/." + target.fileName() + "-" + Utility::CreateUUID() + ".tmp";
+        SaveEntriesAsEpub(entries, tempFile);
+
+        if (Utility::ReplaceFile(tempFile, m_FullFilePath)) {
+            return;
+        }
 
-    if (m_Book->HasObfuscatedFonts()) {
-        ObfuscateFonts(tempfolder.GetPath());
+        bool copied = CopyFileContents(tempFile, m_FullFilePath);
+        QFile::remove(tempFile);
+        if (!copied) {
+            throw(CannotCopyFile(m_FullFilePath.toStdString()));
+        }
+        return;
     }
 
-    SaveFolderAsEpubToLocation(tempfolder.GetPath(), m_FullFilePath);
+    // Only the target itself may be writable.
+    TempFolder tempfolder;
+    QString tempFile = tempfolder.GetPath() + "-tmp.epub";
+    SaveEntriesAsEpub(entries, tempFile);
+    bool copied = CopyFileContents(tempFile, m_FullFilePath);
+    QFile::remove(tempFile);
+    if (!copied) {
+        throw(CannotCopyFile(m_FullFilePath.toStdString()));
+    }
 }
 
 
-// Creates the publication from the Book
-// (creates XHTML, CSS, OPF, NCX files etc.)
-void ExportEPUB::CreatePublication(const QString &fullfolderpath)
+QList<ExportEPUB::ExportEntry> ExportEPUB::GetExportEntries()
 {
-    Utility::CopyFiles(m_Book->GetFolderKeeper()->GetFullPathToMainFolder(), fullfolderpath);
+    QString mainfolder = m_Book->GetFolderKeeper()->GetFullPathToMainFolder();
+    QHash<QString, Resource *> bookpath2resource;
+    foreach(Resource *resource, m_Book->GetFolderKeeper()->GetResourceList()) {
+        bookpath2resource[resource->GetRelativePath()] = resource;
+    }
 
-    if (m_Book->HasObfuscatedFonts()) {
-        CreateEncryptionXML(fullfolderpath + METAINF_FOLDER_SUFFIX);
+    QString uuid_id;
+    QString main_id;
+    bool obfuscated_fonts = m_Book->HasObfuscatedFonts();
+    if (obfuscated_fonts) {
+        uuid_id = m_Book->GetOPF()->GetUUIDIdentifierValue();
+        main_id = m_Book->GetPublicationIdentifier();
+    }
+
+    SettingsStore settings;
+    int profile_level = PROFILE_LEVELS.value(settings.exportCompression(), PROFILE_LEVELS.value("balanced"));
+
+    QList<ExportEntry> entries;
+    bool has_encryption_xml = false;
+    QDirIterator it(mainfolder, QDir::Files | QDir::NoDotAndDotDot | QDir::Readable | QDir::Hidden, QDirIterator::Subdirectories);
+
+    while (it.hasNext()) {
+        it.next();
+        QString relpath = it.filePath().remove(mainfolder);
+
+        while (relpath.startsWith("/")) {
+            relpath = relpath.remove(0, 1);
+        }
+
+        if (relpath == METAINF_FOLDER + "/" + ENCRYPTION_XML_FILE_NAME) {
+            has_encryption_xml = true;
+        }
+
+        ExportEntry entry;
+        entry.bookpath = relpath;
+        entry.fullpath = it.filePath();
+        entry.text_resource = NULL;
+        Resource *resource = bookpath2resource.value(relpath, NULL);
+        TextResource *text_resource = qobject_cast<TextResource *>(resource);
+        FontResource *font_resource = qobject_cast<FontResource *>(resource);
+
+        // Unloaded text is only on disk.
+        if (text_resource && text_resource->IsLoaded()) {
+            entry.text_resource = text_resource;
+        } else if (obfuscated_fonts && font_resource && !font_resource->GetObfuscationAlgorithm().isEmpty()) {
+            entry.algorithm = font_resource->GetObfuscationAlgorithm();
+            entry.key = FontObfuscation::KeyFromIdentifier(entry.algorithm,
+                                                           entry.algorithm == ADOBE_FONT_ALGO_ID ? uuid_id : main_id);
+        }
+
+        entry.mediatype = resource ? resource->GetMediaType()
+                                   : MediaTypes::instance()->GetMediaTypeFromExtension(it.fileInfo().suffix().toLower());
+        entry.level = CompressionLevel(entry.mediatype, entry.fullpath, profile_level);
+        entries.append(entry);
+    }
+
+    // The book's own encryption.xml wins over the generated one,
+    // as it always has; it may describe more than obfuscated fonts.
+    if (obfuscated_fonts && !has_encryption_xml) {
+        ExportEntry entry;
+        entry.bookpath = METAINF_FOLDER + "/" + ENCRYPTION_XML_FILE_NAME;
+        entry.text_resource = NULL;
+        entry.data = CreateEncryptionXML();
+        entry.level = profile_level;
+        entries.append(entry);
     }
+
+    return entries;
 }
 
-void ExportEPUB::SaveFolderAsEpubToLocation(const QString &fullfolderpath, const QString &fullfilepath)
+
+void ExportEPUB::SaveEntriesAsEpub(const QList<ExportEntry> &entries, const QString &fullfilepath)
 {
-    QString tempFile = fullfolderpath + "-tmp.epub";
     QDateTime timeNow = QDateTime::currentDateTime();
     zip_fileinfo fileInfo;
 #ifdef Q_OS_WIN32
     zlib_filefunc64_def ffunc;
     fill_win32_filefunc64W(&ffunc);
-    zipFile zfile = zipOpen2_64(Utility::QStringToStdWString(QDir::toNativeSeparators(tempFile)).c_str(), APPEND_STATUS_CREATE, NULL, &ffunc);
+    zipFile zfile = zipOpen2_64(Utility::QStringToStdWString(QDir::toNativeSeparators(fullfilepath)).c_str(), APPEND_STATUS_CREATE, NULL, &ffunc);
 #else
-    zipFile zfile = zipOpen64(QDir::toNativeSeparators(tempFile).toUtf8().constData(), APPEND_STATUS_CREATE);
+    zipFile zfile = zipOpen64(QDir::toNativeSeparators(fullfilepath).toUtf8().constData(), APPEND_STATUS_CREATE);
 #endif
 
     if (zfile == NULL) {
-        throw (CannotOpenFile(tempFile.toStdString()));
+        throw (CannotOpenFile(fullfilepath.toStdString()));
     }
 
     memset(&fileInfo, 0, sizeof(fileInfo));
@@ -143,160 +473,179 @@ void ExportEPUB::SaveFolderAsEpubToLocation(const QString &fullfolderpath, const
     // Write the mimetype. This must be uncompressed and the first entry in the archive.
     if (zipOpenNewFileInZip64(zfile, "mimetype", &fileInfo, NULL, 0, NULL, 0, NULL, Z_NO_COMPRESSION, 0, 0) != ZIP_OK) {
         zipClose(zfile, NULL);
-        QFile::remove(tempFile);
+        QFile::remove(fullfilepath);
         throw(CannotStoreFile("mimetype"));
     }
 
     if (zipWriteInFileInZip(zfile, EPUB_MIME_DATA, (unsigned int)strlen(EPUB_MIME_DATA)) != ZIP_OK) {
         zipCloseFileInZip(zfile);
         zipClose(zfile, NULL);
-        QFile::remove(tempFile);
+        QFile::remove(fullfilepath);
         throw(CannotStoreFile("mimetype"));
     }
 
     zipCloseFileInZip(zfile);
-    // Write all the files in our directory path to the archive.
-    QDirIterator it(fullfolderpath, QDir::Files | QDir::NoDotAndDotDot | QDir::Readable | QDir::Hidden, QDirIterator::Subdirectories);
-
-    while (it.hasNext()) {
-        it.next();
-        QString relpath = it.filePath().remove(fullfolderpath);
 
-        while (relpath.startsWith("/")) {
-            relpath = relpath.remove(0, 1);
+    // Cut the entries into chunks that are compressed on the thread pool.
+    // Chunks of one entry are joined by ending all but the last with a
+    // sync flush, and each is primed with the input before it, so the
+    // output does not depend on the number of threads.
+    QList<CompressChunk> chunks;
+    QList<qint64> entry_sizes;
+    for (int i = 0; i < entries.count(); ++i) {
+        const ExportEntry &entry = entries.at(i);
+        CompressChunk chunk;
+        chunk.entry = i;
+        chunk.level = entry.level;
+        chunk.from_memory = entry.text_resource || entry.fullpath.isEmpty();
+        if (chunk.from_memory) {
+            chunk.data = entry.text_resource ? TextFileContents(entry.text_resource->GetText()) : entry.data;
+        } else {
+            chunk.fullpath = entry.fullpath;
         }
+        chunk.algorithm = entry.algorithm;
+        chunk.key = entry.key;
+        qint64 size = chunk.from_memory ? chunk.data.size() : QFileInfo(entry.fullpath).size();
+        entry_sizes.append(size);
+
+        qint64 offset = 0;
+        do {
+            chunk.offset = offset;
+            chunk.length = qMin(DEFLATE_CHUNK_SIZE, size - offset);
+            chunk.first = offset == 0;
+            chunk.last = offset + chunk.length >= size;
+            chunks.append(chunk);
+            offset += chunk.length;
+        } while (offset < size);
+    }
 
-        // Add the file entry to the archive.
-        // We should check the uncompressed file size. If it's over >= 0xffffffff the last parameter (zip64) should be 1.
-        if (zipOpenNewFileInZip4_64(zfile, relpath.toUtf8().constData(), &fileInfo, NULL, 0, NULL, 0, NULL, Z_DEFLATED, 8, 0, 15, 8, Z_DEFAULT_STRATEGY, NULL, 0, 0x0b00, 1<<11, 0) != ZIP_OK) {
-            zipClose(zfile, NULL);
-            QFile::remove(tempFile);
-            throw(CannotStoreFile(relpath.toStdString()));
+    QElapsedTimer timer;
+    timer.start();
+    QString failed;
+    uLong crc = 0;
+    qint64 total = 0;
+    qint64 total_compressed = 0;
+    qint64 compressed_size = 0;
+    qint64 nsecs = 0;
+    QStringList report;
+    int start = 0;
+    int end = NextBatchEnd(chunks, start);
+    QFuture<CompressedChunk> compressing = QtConcurrent::mapped(chunks.mid(start, end - start), CompressOneChunk);
+
+    while (start < chunks.count()) {
+        // Keep the pool busy with the next batch while this one is written.
+        int upcoming_end = NextBatchEnd(chunks, end);
+        QFuture<CompressedChunk> upcoming;
+        if (upcoming_end > end) {
+            upcoming = QtConcurrent::mapped(chunks.mid(end, upcoming_end - end), CompressOneChunk);
         }
 
-        // Open the file on disk. We will read this and write what we read into
-        // the archive.
-        QFile dfile(it.filePath());
-
-        if (!dfile.open(QIODevice::ReadOnly)) {
-            zipCloseFileInZip(zfile);
-            zipClose(zfile, NULL);
-            QFile::remove(tempFile);
-            throw(CannotOpenFile(it.fileName().toStdString()));
-        }
+        for (int i = start; i < end; ++i) {
+            const CompressChunk &chunk = chunks.at(i);
+            const ExportEntry &entry = entries.at(chunk.entry);
+            qint64 size = entry_sizes.at(chunk.entry);
+
+            if (chunk.first) {
+                // Sizes past 4GB need the zip64 extra field in the local header.
+                int zip64 = size >= 0xffffffff ? 1 : 0;
+                int method = entry.level == 0 ? 0 : Z_DEFLATED;
+                if (zipOpenNewFileInZip4_64(zfile, entry.bookpath.toUtf8().constData(), &fileInfo, NULL, 0, NULL, 0, NULL, method, entry.level, 1, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY, NULL, 0, 0x0b00, 1<<11, zip64) != ZIP_OK) {
+                    failed = entry.bookpath;
+                    break;
+                }
+                crc = crc32(0L, Z_NULL, 0);
+                compressed_size = 0;
+                nsecs = 0;
+            }
 
-        // Write the data from the file on disk into the archive.
-        char buff[BUFF_SIZE] = {0};
-        qint64 read = 0;
+            CompressedChunk result = compressing.resultAt(i - start);
 
-        while ((read = dfile.read(buff, BUFF_SIZE)) > 0) {
-            if (zipWriteInFileInZip(zfile, buff, read) != ZIP_OK) {
-                dfile.close();
+            if (!result.ok ||
+                zipWriteInFileInZip(zfile, result.compressed.constData(), (unsigned int)result.compressed.size()) != ZIP_OK) {
                 zipCloseFileInZip(zfile);
-                zipClose(zfile, NULL);
-                QFile::remove(tempFile);
-                throw(CannotStoreFile(relpath.toStdString()));
+                failed = entry.bookpath;
+                break;
             }
-        }
-
-        dfile.close();
 
-        // There was an error reading the file on disk.
-        if (read < 0) {
-            zipCloseFileInZip(zfile);
-            zipClose(zfile, NULL);
-            QFile::remove(tempFile);
-            throw(CannotStoreFile(relpath.toStdString()));
+            crc = crc32_combine(crc, result.crc, chunk.length);
+            compressed_size += result.compressed.size();
+            nsecs += result.nsecs;
+
+            if (chunk.last) {
+                if (zipCloseFileInZipRaw64(zfile, size, crc) != ZIP_OK) {
+                    failed = entry.bookpath;
+                    break;
+                }
+                total += size;
+                total_compressed += compressed_size;
+                // book paths may hold a % so they are not passed through arg()
+                QString decision = entry.level == 0 ? QString("stored") : QString("deflated(%1)").arg(entry.level);
+                report << decision + " " + entry.bookpath + " " +
+                          QString("%1 -> %2 bytes (%3%) in %4 ms, ")
+                          .arg(size)
+                          .arg(compressed_size)
+                          .arg(size > 0 ? 100.0 * compressed_size / size : 100.0, 0, 'f', 1)
+                          .arg(nsecs / 1000000.0, 0, 'f', 2) +
+                          (entry.mediatype.isEmpty() ? QString("unknown media type") : entry.mediatype);
+            }
         }
 
-        if (zipCloseFileInZip(zfile) != ZIP_OK) {
-            zipClose(zfile, NULL);
-            QFile::remove(tempFile);
-            throw(CannotStoreFile(relpath.toStdString()));
+        if (!failed.isEmpty()) {
+            compressing.cancel();
+            upcoming.cancel();
+            compressing.waitForFinished();
+            upcoming.waitForFinished();
+            break;
         }
-    }
 
-    zipClose(zfile, NULL);
-    // Overwrite the contents of the real file with the contents from the temp
-    // file we saved the data do. We do this instead of simply copying the file
-    // because a file copy will lose extended attributes such as labels on OS X.
-    QFile temp_epub(tempFile);
-
-    if (!temp_epub.open(QFile::ReadOnly)) {
-        throw(CannotOpenFile(tempFile.toStdString()));
+        compressing = upcoming;
+        start = end;
+        end = upcoming_end;
     }
 
-    QFile real_epub(fullfilepath);
-
-    if (!real_epub.open(QFile::WriteOnly | QFile::Truncate)) {
-        temp_epub.close();
-        throw(CannotWriteFile(fullfilepath.toStdString()));
+    if (!failed.isEmpty()) {
+        zipClose(zfile, NULL);
+        QFile::remove(fullfilepath);
+        throw(CannotStoreFile(failed.toStdString()));
     }
 
-    // Copy the contents from the temp file to the real file.
-    char buff[BUFF_SIZE] = {0};
-    qint64 read = 0;
-    qint64 written = 0;
-
-    while ((read = temp_epub.read(buff, BUFF_SIZE)) > 0) {
-        written = real_epub.write(buff, read);
-
-        if (written != read) {
-            temp_epub.close();
-            real_epub.close();
-            QFile::remove(tempFile);
-            throw(CannotCopyFile(fullfilepath.toStdString()));
+    // Set SIGIL_DEBUG_TIMING to see where the time went
+    bool debug_timing = qEnvironmentVariableIsSet("SIGIL_DEBUG_TIMING");
+    if (debug_timing) {
+        qDebug() << "Saved" << total / 1024 << "KB as" << total_compressed / 1024 << "KB in" << timer.elapsed() << "ms on"
+                 << QThreadPool::globalInstance()->maxThreadCount() << "threads";
+        foreach(QString line, report) {
+            qDebug() << qPrintable(line);
         }
     }
 
-    if (read == -1) {
-        temp_epub.close();
-        real_epub.close();
-        QFile::remove(tempFile);
-        throw(CannotCopyFile(fullfilepath.toStdString()));
+    if (zipClose(zfile, NULL) != ZIP_OK) {
+        QFile::remove(fullfilepath);
+        throw(CannotWriteFile(fullfilepath.toStdString()));
     }
 
-    temp_epub.close();
-    real_epub.close();
-    QFile::remove(tempFile);
-}
-
-
-void ExportEPUB::CreateEncryptionXML(const QString &fullfolderpath)
-{
-    QTemporaryFile file;
-
-    if (!file.open()) {
-    std::string msg = file.fileName().toStdString() + ": " + file.errorString().toStdString();
-        throw (CannotOpenFile(msg));
+    // The report of the last save is kept in the preferences folder,
+    // which Preferences can open, see the compression setting there.
+    report.prepend(QString("%1 KB saved as %2 KB in %3 ms")
+                   .arg(total / 1024)
+                   .arg(total_compressed / 1024)
+                   .arg(timer.elapsed()));
+    report.prepend(QDir::toNativeSeparators(m_FullFilePath));
+    try {
+        Utility::WriteUnicodeTextFile(report.join("\n") + "\n", Utility::DefinePrefsDir() + "/" + EXPORT_REPORT_FILE_NAME);
+    } catch (CannotOpenFile) {
+        // the report is not worth failing the save for
     }
-
-    EncryptionXmlWriter enc(m_Book.data(), file);
-    enc.WriteXML();
-    // Write to disk immediately
-    file.flush();
-    QFile::copy(file.fileName(), fullfolderpath + "/" + ENCRYPTION_XML_FILE_NAME);
 }
 
 
-void ExportEPUB::ObfuscateFonts(const QString &fullfolderpath)
+QByteArray ExportEPUB::CreateEncryptionXML()
 {
-    QString uuid_id = m_Book->GetOPF()->GetUUIDIdentifierValue();
-    QString main_id = m_Book->GetPublicationIdentifier();
-    QList<FontResource *> font_resources = m_Book->GetFolderKeeper()->GetResourceTypeList<FontResource>();
-    foreach(FontResource *font_resource, font_resources) {
-        QString algorithm = font_resource->GetObfuscationAlgorithm();
-
-        if (algorithm.isEmpty()) {
-            continue;
-        }
-
-        QString font_path = fullfolderpath + "/" + font_resource->GetRelativePath();
-
-        if (algorithm == ADOBE_FONT_ALGO_ID) {
-            FontObfuscation::ObfuscateFile(font_path, algorithm, uuid_id);
-        } else {
-            FontObfuscation::ObfuscateFile(font_path, algorithm, main_id);
-        }
-    }
+    QByteArray data;
+    QBuffer buffer(&data);
+    buffer.open(QIODevice::WriteOnly);
+    EncryptionXmlWriter enc(m_Book.data(), buffer);
+    enc.WriteXML();
+    buffer.close();
+    return data;
 }
@@ -28,6 +28,8 @@
 #include "BookManipulation/Book.h"
 #include "Exporters/Exporter.h"
 
+class TextResource;
+
 class ExportEPUB : public Exporter
 {
 
@@ -47,22 +49,46 @@ public:
 
 private:
 
-    // Creates the publication from the Book
-    // (creates XHTML, CSS, OPF, NCX files etc.)
-    void virtual CreatePublication(const QString &fullfolderpath);
-
-    // Saves the publication in the specified folder
-    // to the specified file path as an epub;
-    // the second optional parameter specifies the
-    // mimetype to write to the special "mimetype" file
-    void SaveFolderAsEpubToLocation(const QString &fullfolderpath, const QString &fullfilepath);
-
-    // Creates the publication's encryption.xml file,
-    // if there are any fonts to obfuscate
-    void CreateEncryptionXML(const QString &fullfolderpath);
-
-    // Obfuscates the fonts marked for obfuscation
-    void ObfuscateFonts(const QString &fullfolderpath);
+    /**
+     * One file of the publication as it goes into the archive.
+     * Text the book holds in memory is written from there,
+     * everything else is streamed from the book folder.
+     */
+    struct ExportEntry {
+        // The path of the entry in the archive
+        QString bookpath;
+
+        // The file to stream the entry from
+        QString fullpath;
+
+        // The resource whose text is the entry, if it is loaded
+        TextResource *text_resource;
+
+        // Content generated for the export only
+        QByteArray data;
+
+        // The font obfuscation algorithm to apply, if any,
+        // and the key it derived from the book identifier
+        QString algorithm;
+        QByteArray key;
+
+        // The media type the compression was chosen for
+        // and the deflate level, 0 stores the entry as it is
+        QString mediatype;
+        int level;
+    };
+
+    // Lists the entries of the publication, in the
+    // order they are written after the mimetype
+    QList<ExportEntry> GetExportEntries();
+
+    // Writes the entries to the specified file path as an epub,
+    // deflating them on the thread pool, and writes a report of
+    // the size and time of every entry to the preferences folder
+    void SaveEntriesAsEpub(const QList<ExportEntry> &entries, const QString &fullfilepath);
+
+    // Creates the publication's encryption.xml file
+    QByteArray CreateEncryptionXML();
 
 
     ///////////////////////////////
@@ -68,6 +68,12 @@ void NCXWriter::WriteXMLFromHeadings()
 }
 
 
+void NCXWriter::SetPageList(const QList<NavPageListEntry> &pagelist)
+{
+    m_PageList = pagelist;
+}
+
+
 void NCXWriter::WriteXML()
 {
     m_Writer->writeStartDocument();
@@ -80,7 +86,10 @@ void NCXWriter::WriteXML()
     m_Writer->writeAttribute("version", "2005-1");
     WriteHead();
     WriteDocTitle();
-    WriteNavMap();
+    int play_order = WriteNavMap();
+    if (!m_PageList.isEmpty()) {
+        WritePageList(play_order);
+    }
     m_Writer->writeEndElement();
     m_Writer->writeEndDocument();
 }
@@ -97,10 +106,10 @@ void NCXWriter::WriteHead()
     m_Writer->writeAttribute("content", QString::number(GetTOCDepth()));
     m_Writer->writeEmptyElement("meta");
     m_Writer->writeAttribute("name", "dtb:totalPageCount");
-    m_Writer->writeAttribute("content", "0");
+    m_Writer->writeAttribute("content", QString::number(m_PageList.count()));
     m_Writer->writeEmptyElement("meta");
     m_Writer->writeAttribute("name", "dtb:maxPageNumber");
-    m_Writer->writeAttribute("content", "0");
+    m_Writer->writeAttribute("content", QString::number(m_PageList.count()));
     m_Writer->writeEndElement();
 }
 
@@ -122,7 +131,7 @@ void NCXWriter::WriteDocTitle()
 }
 
 
-void NCXWriter::WriteNavMap()
+int NCXWriter::WriteNavMap()
 {
     int play_order = 1;
     m_Writer->writeStartElement("navMap");
@@ -138,9 +147,33 @@ void NCXWriter::WriteNavMap()
         // with a NavMap with at least one NavPoint, so we
         // write a dummy one.
         WriteFallbackNavPoint();
+        play_order++;
     }
 
     m_Writer->writeEndElement();
+    return play_order;
+}
+
+
+void NCXWriter::WritePageList(int play_order)
+{
+    m_Writer->writeStartElement("pageList");
+    foreach(NavPageListEntry page, m_PageList) {
+        m_Writer->writeStartElement("pageTarget");
+        m_Writer->writeAttribute("id", QString("navPoint-%1").arg(play_order));
+        m_Writer->writeAttribute("type", "normal");
+        m_Writer->writeAttribute("value", page.pagename);
+        m_Writer->writeAttribute("playOrder", QString("%1").arg(play_order));
+        play_order++;
+        m_Writer->writeStartElement("navLabel");
+        m_Writer->writeTextElement("text", page.pagename);
+        m_Writer->writeEndElement();
+        m_Writer->writeEmptyElement("content");
+        // page hrefs are decoded book paths
+        m_Writer->writeAttribute("src", Utility::URLEncodePath(ConvertBookPathToNCXRelative(page.href)));
+        m_Writer->writeEndElement();
+    }
+    m_Writer->writeEndElement();
 }
 
 
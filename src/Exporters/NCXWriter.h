@@ -27,6 +27,7 @@
 #include "BookManipulation/Headings.h"
 #include "Exporters/XMLWriter.h"
 #include "MainUI/TOCModel.h"
+#include "ResourceObjects/NavProcessor.h"
 
 class Resource;
 
@@ -52,6 +53,12 @@ public:
 
     void WriteXMLFromHeadings();
 
+    /**
+     * Sets the pages written to the <pageList> element.
+     * The hrefs of the entries must be book paths.
+     */
+    void SetPageList(const QList<NavPageListEntry> &pagelist);
+
 private:
 
     /**
@@ -66,8 +73,17 @@ private:
 
     /**
      * Writes the <navMap> element.
+     *
+     * @return The next free playorder.
      */
-    void WriteNavMap();
+    int WriteNavMap();
+
+    /**
+     * Writes the <pageList> element.
+     *
+     * @param play_order The playorder of the first page target.
+     */
+    void WritePageList(int play_order);
 
     /**
      * Writes a fallback <navPoint> for when the book has no headings.
@@ -116,6 +132,8 @@ private:
 
     TOCModel::TOCEntry m_TOCRootEntry;
 
+    QList<NavPageListEntry> m_PageList;
+
     QString m_version;
     const Resource * m_ncxresource;
 };
@@ -30,6 +30,8 @@
 #include "iowin32.h"
 #endif
 
+#include <algorithm>
+#include <functional>
 #include <string>
 
 #include <QApplication>
@@ -152,51 +154,50 @@ QSharedPointer<Book> ImportEPUB::GetBook(bool extract_metadata)
 
     const QList<Resource *> resources = m_Book->GetFolderKeeper()->GetResourceList();
 
-    // We're going to check all html files until we find one that isn't well formed then we'll prompt
-    // the user if they want to auto fix or not.
-    //
-    // If we have non-well formed content and they shouldn't be auto fixed we'll pass that on to
-    // the universal update function so it knows to skip them. Otherwise we won't include them and
-    // let it modify the file.
-    for (int i=0; i<resources.count(); ++i) {
-        if (resources.at(i)->Type() == Resource::HTMLResourceType) {
-            HTMLResource *hresource = qobject_cast<HTMLResource *>(resources.at(i));
-            if (!hresource) {
-                continue;
-            }
-            // Load the content into the HTMLResource so we can perform a well formed check.
-            try {
-                hresource->SetText(HTMLEncodingResolver::ReadHTMLFile(hresource->GetFullPath()));
-            } catch (...) {
-                if (ss.cleanOn() & CLEANON_OPEN) {
-                    non_well_formed << hresource;
-                    continue;
-                }
-            }
-            if (ss.cleanOn() & CLEANON_OPEN) {
-                if (!XhtmlDoc::IsDataWellFormed(hresource->GetText(),hresource->GetEpubVersion())) {
-                    non_well_formed << hresource;
-                }
+    // All html files are read and checked in one parallel pass. If any of them are
+    // not well formed we prompt the user if they want to auto fix or not, listing
+    // the errors found. Only those files are mended, nothing is checked twice.
+    bool clean_on_open = ss.cleanOn() & CLEANON_OPEN;
+    QStringList error_details;
+    QList<HTMLValidation> validations = ValidateHTMLFiles(resources, clean_on_open);
+    if (clean_on_open) {
+        foreach(HTMLValidation validation, validations) {
+            QString bookpath = validation.resource->GetRelativePath();
+            if (!validation.loaded) {
+                non_well_formed << validation.resource;
+                error_details << tr("%1: could not be read").arg(bookpath);
+            } else if (validation.error.line != -1) {
+                non_well_formed << validation.resource;
+                error_details << tr("%1: line %2, column %3: %4").arg(bookpath)
+                                                                 .arg(validation.error.line)
+                                                                 .arg(validation.error.column)
+                                                                 .arg(validation.error.message);
             }
         }
     }
     if (!non_well_formed.isEmpty()) {
         QApplication::restoreOverrideCursor();
-        if (QMessageBox::Yes == QMessageBox::warning(QApplication::activeWindow(),
-                tr("Sigil"),
-                tr("This EPUB has HTML files that are not well formed. "
-                   "Sigil can attempt to automatically fix these files, although this "
-                   "can result in minor data loss.\n\n"
-                   "Do you want to automatically fix the files?"),
-                QMessageBox::Yes|QMessageBox::No)) 
-        {
-	    foreach(HTMLResource* htmlres, non_well_formed) {
-		QString fixed_text = CleanSource::Mend(htmlres->GetText(),htmlres->GetEpubVersion());
-                htmlres->SetText(fixed_text);
-	    }
+        QMessageBox msgbox(QMessageBox::Warning,
+                           tr("Sigil"),
+                           tr("This EPUB has HTML files that are not well formed. "
+                              "Sigil can attempt to automatically fix these files, although this "
+                              "can result in minor data loss.\n\n"
+                              "Do you want to automatically fix the files?"),
+                           QMessageBox::Yes|QMessageBox::No,
+                           QApplication::activeWindow());
+        msgbox.setDetailedText(error_details.join("\n"));
+        bool fix = msgbox.exec() == QMessageBox::Yes;
+        QApplication::setOverrideCursor(Qt::WaitCursor);
+        if (fix) {
+            // Only the files known to be broken are mended.
+            QFuture<std::pair<HTMLResource *, QString>> mend_future;
+            mend_future = QtConcurrent::mapped(non_well_formed, MendOneHTMLFile);
+            const QList<std::pair<HTMLResource *, QString>> mended = mend_future.results();
+            for (int i = 0; i < mended.count(); i++) {
+                mended.at(i).first->SetText(mended.at(i).second);
+            }
             non_well_formed.clear();
         }
-        QApplication::setOverrideCursor(Qt::WaitCursor);
     }
 
     ProcessFontFiles(resources, encrypted_files);
@@ -388,24 +389,39 @@ void ImportEPUB::ProcessFontFiles(const QList<Resource *> &resources,
     }
 }
 
-void ImportEPUB::ExtractContainer()
+static unzFile OpenZipFile(const QString &fullfilepath)
 {
-    int res = 0;
-    if (!cp437) {
-        cp437 = new QCodePage437Codec();
-    }
 #ifdef Q_OS_WIN32
     zlib_filefunc64_def ffunc;
     fill_win32_filefunc64W(&ffunc);
-    unzFile zfile = unzOpen2_64(Utility::QStringToStdWString(QDir::toNativeSeparators(m_FullFilePath)).c_str(), &ffunc);
+    return unzOpen2_64(Utility::QStringToStdWString(QDir::toNativeSeparators(fullfilepath)).c_str(), &ffunc);
 #else
-    unzFile zfile = unzOpen64(QDir::toNativeSeparators(m_FullFilePath).toUtf8().constData());
+    return unzOpen64(QDir::toNativeSeparators(fullfilepath).toUtf8().constData());
 #endif
+}
+
+
+void ImportEPUB::ExtractContainer()
+{
+    int res = 0;
+    if (!cp437) {
+        cp437 = new QCodePage437Codec();
+    }
+    unzFile zfile = OpenZipFile(m_FullFilePath);
 
     if (zfile == NULL) {
         throw (EPUBLoadParseError(QString(QObject::tr("Cannot unzip EPUB: %1")).arg(QDir::toNativeSeparators(m_FullFilePath)).toStdString()));
     }
 
+    // The central directory is walked once to check the names and create
+    // the folders, the entries themselves are then inflated in parallel.
+    QList<ZipEntry> entries;
+    // For each entry the index of the last later entry that writes the
+    // same file, see below.
+    QList<int> last_colliding;
+    QHash<QString, int> last_entry_for_name;
+    qint64 total_size = 0;
+
     res = unzGoToFirstFile(zfile);
 
     if (res == UNZ_OK) {
@@ -457,7 +473,6 @@ void ImportEPUB::ExtractContainer()
 		}
 
                 if (evil_or_corrupt_epub) {
-                    unzCloseCurrentFile(zfile);
                     unzClose(zfile);
                     throw (EPUBLoadParseError(QString(QObject::tr("Possible evil or corrupt epub file name: %1")).arg(original_path).toStdString()));
                 }
@@ -483,49 +498,37 @@ void ImportEPUB::ExtractContainer()
 		    }
                 }
 
-                // Open the file entry in the archive for reading.
-                if (unzOpenCurrentFile(zfile) != UNZ_OK) {
-                    unzClose(zfile);
-                    throw (EPUBLoadParseError(QString(QObject::tr("Cannot extract file: %1")).arg(qfile_name).toStdString()));
-                }
-
-                // Open the file on disk to write the entry in the archive to.
-                QFile entry(file_path);
-
-                if (!entry.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
-                    unzCloseCurrentFile(zfile);
-                    unzClose(zfile);
-                    throw (EPUBLoadParseError(QString(QObject::tr("Cannot extract file: %1")).arg(qfile_name).toStdString()));
-                }
-
-                // Buffered reading and writing.
-                char buff[BUFF_SIZE] = {0};
-                int read = 0;
-
-                while ((read = unzReadCurrentFile(zfile, buff, BUFF_SIZE)) > 0) {
-                    entry.write(buff, read);
-                }
-
-                entry.close();
-
-                // Read errors are marked by a negative read amount.
-                if (read < 0) {
-                    unzCloseCurrentFile(zfile);
-                    unzClose(zfile);
-                    throw (EPUBLoadParseError(QString(QObject::tr("Cannot extract file: %1")).arg(qfile_name).toStdString()));
+                unz64_file_pos file_pos;
+                unzGetFilePos64(zfile, &file_pos);
+                ZipEntry entry;
+                entry.pos_in_zip_directory = file_pos.pos_in_zip_directory;
+                entry.num_of_file = file_pos.num_of_file;
+                entry.file_name = qfile_name;
+                entry.cp437_file_name = cp437_file_name;
+                entry.compressed_size = file_info.compressed_size;
+                if (!cp437_file_name.isEmpty() && cp437_file_name != qfile_name) {
+                    m_CP437Aliases[qfile_name] = cp437_file_name;
+                    m_CP437Aliases[cp437_file_name] = qfile_name;
                 }
 
-                // The file was read but the CRC did not match.
-                // We don't check the read file size vs the uncompressed file size
-                // because if they're different there should be a CRC error.
-                if (unzCloseCurrentFile(zfile) == UNZ_CRCERROR) {
-                    unzClose(zfile);
-                    throw (EPUBLoadParseError(QString(QObject::tr("Cannot extract file: %1")).arg(qfile_name).toStdString()));
-                }
+                // Entries that write the same file, either under the same name
+                // or one differing only in case on Windows and macOS, must be
+                // extracted by one worker in archive order so the last one wins
+                // as before. The cp437 alias is written as well, so it counts.
+                QStringList names;
+                names << qfile_name.toCaseFolded();
                 if (!cp437_file_name.isEmpty() && cp437_file_name != qfile_name) {
-                    QString cp437_file_path = m_ExtractedFolderPath + "/" + cp437_file_name;
-                    QFile::copy(file_path, cp437_file_path);
+                    names << cp437_file_name.toCaseFolded();
+                }
+                last_colliding << entries.count();
+                foreach(QString name, names) {
+                    if (last_entry_for_name.contains(name)) {
+                        last_colliding[last_entry_for_name.value(name)] = entries.count();
+                    }
+                    last_entry_for_name[name] = entries.count();
                 }
+                entries << entry;
+                total_size += entry.compressed_size;
             }
         } while ((res = unzGoToNextFile(zfile)) == UNZ_OK);
     }
@@ -536,6 +539,98 @@ void ImportEPUB::ExtractContainer()
     }
 
     unzClose(zfile);
+
+    // Each worker gets a contiguous run of entries of about the same compressed
+    // size so it reads its part of the archive front to back. A run is never
+    // ended before the last entry colliding with one of its entries.
+    int num_workers = qMax(1, qMin(QThread::idealThreadCount(), entries.count()));
+    qint64 run_size = total_size / num_workers + 1;
+    QFutureSynchronizer<QString> sync;
+    int start = 0;
+    int run_reach = 0;
+    qint64 size = 0;
+    for (int i = 0; i < entries.count(); ++i) {
+        size += entries.at(i).compressed_size;
+        run_reach = qMax(run_reach, last_colliding.at(i));
+        if ((size >= run_size && run_reach <= i) || i == entries.count() - 1) {
+            sync.addFuture(QtConcurrent::run(this, &ImportEPUB::ExtractZipEntries, entries, start, i + 1));
+            start = i + 1;
+            size = 0;
+        }
+    }
+    sync.waitForFinished();
+
+    foreach(QFuture<QString> future, sync.futures()) {
+        if (!future.result().isEmpty()) {
+            throw (EPUBLoadParseError(future.result().toStdString()));
+        }
+    }
+}
+
+
+QString ImportEPUB::ExtractZipEntries(const QList<ZipEntry> &entries, int start, int end)
+{
+    unzFile zfile = OpenZipFile(m_FullFilePath);
+
+    if (zfile == NULL) {
+        return QString(QObject::tr("Cannot unzip EPUB: %1")).arg(QDir::toNativeSeparators(m_FullFilePath));
+    }
+
+    // Buffered reading and writing.
+    QByteArray buffer(BUFF_SIZE * 8, 0);
+
+    for (int i = start; i < end; ++i) {
+        const ZipEntry &zip_entry = entries.at(i);
+        QString file_path = m_ExtractedFolderPath + "/" + zip_entry.file_name;
+        unz64_file_pos file_pos;
+        file_pos.pos_in_zip_directory = zip_entry.pos_in_zip_directory;
+        file_pos.num_of_file = zip_entry.num_of_file;
+
+        // Open the file entry in the archive for reading.
+        if (unzGoToFilePos64(zfile, &file_pos) != UNZ_OK || unzOpenCurrentFile(zfile) != UNZ_OK) {
+            unzClose(zfile);
+            return QString(QObject::tr("Cannot extract file: %1")).arg(zip_entry.file_name);
+        }
+
+        // Open the file on disk to write the entry in the archive to.
+        QFile entry(file_path);
+
+        if (!entry.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+            unzCloseCurrentFile(zfile);
+            unzClose(zfile);
+            return QString(QObject::tr("Cannot extract file: %1")).arg(zip_entry.file_name);
+        }
+
+        int read = 0;
+
+        while ((read = unzReadCurrentFile(zfile, buffer.data(), buffer.size())) > 0) {
+            entry.write(buffer.constData(), read);
+        }
+
+        entry.close();
+
+        // Read errors are marked by a negative read amount.
+        if (read < 0) {
+            unzCloseCurrentFile(zfile);
+            unzClose(zfile);
+            return QString(QObject::tr("Cannot extract file: %1")).arg(zip_entry.file_name);
+        }
+
+        // The file was read but the CRC did not match.
+        // We don't check the read file size vs the uncompressed file size
+        // because if they're different there should be a CRC error.
+        if (unzCloseCurrentFile(zfile) == UNZ_CRCERROR) {
+            unzClose(zfile);
+            return QString(QObject::tr("Cannot extract file: %1")).arg(zip_entry.file_name);
+        }
+        if (!zip_entry.cp437_file_name.isEmpty() && zip_entry.cp437_file_name != zip_entry.file_name) {
+            QString cp437_file_path = m_ExtractedFolderPath + "/" + zip_entry.cp437_file_name;
+            Utility::LinkOrCopyFile(file_path, cp437_file_path);
+        }
+    }
+
+    unzClose(zfile);
+    return QString();
 }
 
 void ImportEPUB::LocateOPF()
@@ -910,13 +1005,28 @@ bool ImportEPUB::LoadFolderStructure()
 
     QFutureSynchronizer<std::tuple<QString, QString>> sync;
 
+    // The extracted files are only needed to build the book, so they are moved
+    // into it rather than copied. A file that is loaded more than once, or
+    // whose CP437 alias (a hard link to the same data) is loaded as well,
+    // is still copied.
+    QHash<QString, int> source_count;
+    for (int i = 0; i < num_files; ++i) {
+        source_count[ExtractedBookPath(m_Files.value(keys.at(i)))]++;
+    }
+
     for (int i = 0; i < num_files; ++i) {
         QString id = keys.at(i);
+        QString currentpath = ExtractedBookPath(m_Files.value(id));
+        bool move_file = source_count.value(currentpath) == 1;
+        if (m_CP437Aliases.contains(currentpath) && source_count.contains(m_CP437Aliases.value(currentpath))) {
+            move_file = false;
+        }
         sync.addFuture(QtConcurrent::run(
                            this,
                            &ImportEPUB::LoadOneFile,
                            m_Files.value(id),
-                           m_FileMimetypes.value(id)));
+                           m_FileMimetypes.value(id),
+                           move_file));
     }
 
     sync.waitForFinished();
@@ -935,15 +1045,22 @@ bool ImportEPUB::LoadFolderStructure()
 }
 
 
-std::tuple<QString, QString> ImportEPUB::LoadOneFile(const QString &path, const QString &mimetype)
+QString ImportEPUB::ExtractedBookPath(const QString &path) const
+{
+    QString fullfilepath = QDir::cleanPath(QFileInfo(m_OPFFilePath).absolutePath() + "/" + path);
+    return fullfilepath.remove(0,m_ExtractedFolderPath.length()+1);
+}
+
+
+std::tuple<QString, QString> ImportEPUB::LoadOneFile(const QString &path, const QString &mimetype, bool move_file)
 {
     // Use opf relative href to create the book path (currentpath) for this file
     QString fullfilepath = QDir::cleanPath(QFileInfo(m_OPFFilePath).absolutePath() + "/" + path);
-    QString currentpath = fullfilepath;
-    currentpath = currentpath.remove(0,m_ExtractedFolderPath.length()+1);
+    QString currentpath = ExtractedBookPath(path);
     try {
         QString bookpath = currentpath;
-        Resource *resource = m_Book->GetFolderKeeper()->AddContentFileToFolder(fullfilepath, false, mimetype, bookpath);
+        Resource *resource = m_Book->GetFolderKeeper()->AddContentFileToFolder(fullfilepath, false, mimetype, bookpath,
+                                                                               QString("\\"), move_file);
         if (path == m_NavHref) {
             m_NavResource = resource;
         }
@@ -955,6 +1072,76 @@ std::tuple<QString, QString> ImportEPUB::LoadOneFile(const QString &path, const
 }
 
 
+QList<ImportEPUB::HTMLValidation> ImportEPUB::ValidateHTMLFiles(const QList<Resource *> &resources, bool check)
+{
+    QList<HTMLResource *> html_resources;
+    foreach(Resource *resource, resources) {
+        if (resource->Type() == Resource::HTMLResourceType) {
+            HTMLResource *hresource = qobject_cast<HTMLResource *>(resource);
+            if (hresource) {
+                html_resources << hresource;
+            }
+        }
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    QFuture<HTMLValidation> future = QtConcurrent::mapped(html_resources,
+                                                          std::bind(ValidateOneHTMLFile, std::placeholders::_1, check));
+    QList<HTMLValidation> results = future.results();
+
+    // The text is set here on the GUI thread so the resources do not
+    // have to queue a delayed update.
+    foreach(HTMLValidation validation, results) {
+        if (validation.loaded) {
+            validation.resource->SetText(validation.text);
+        }
+    }
+
+    // Set SIGIL_DEBUG_TIMING to see where the time went
+    if (qEnvironmentVariableIsSet("SIGIL_DEBUG_TIMING")) {
+        QList<HTMLValidation> slowest = results;
+        std::sort(slowest.begin(), slowest.end(), [](const HTMLValidation &a, const HTMLValidation &b) {
+            return a.nsecs > b.nsecs;
+        });
+        qDebug() << "HTML validation of" << results.count() << "files:" << timer.elapsed() << "ms";
+        for (int i = 0; i < slowest.count() && i < 10; ++i) {
+            qDebug() << "    " << slowest.at(i).resource->GetRelativePath() << ":"
+                     << slowest.at(i).nsecs / 1000000 << "ms";
+        }
+    }
+    return results;
+}
+
+
+ImportEPUB::HTMLValidation ImportEPUB::ValidateOneHTMLFile(HTMLResource *html_resource, bool check)
+{
+    HTMLValidation validation;
+    validation.resource = html_resource;
+    validation.loaded = false;
+    QElapsedTimer timer;
+    timer.start();
+    try {
+        validation.text = HTMLEncodingResolver::ReadHTMLFile(html_resource->GetFullPath());
+        validation.loaded = true;
+    } catch (...) {
+        // QtConcurrent does not let exceptions cross threads,
+        // the caller sees that the file was not loaded.
+    }
+    if (validation.loaded && check) {
+        validation.error = XhtmlDoc::WellFormedErrorForSource(validation.text, html_resource->GetEpubVersion());
+    }
+    validation.nsecs = timer.nsecsElapsed();
+    return validation;
+}
+
+
+std::pair<HTMLResource *, QString> ImportEPUB::MendOneHTMLFile(HTMLResource *html_resource)
+{
+    return std::make_pair(html_resource, CleanSource::Mend(html_resource->GetText(), html_resource->GetEpubVersion()));
+}
+
+
 QString ImportEPUB::PrepareOPFForReading(const QString &source)
 {
     QString source_copy(source);
@@ -30,6 +30,7 @@
 #include <QtCore/QSet>
 #include <QtCore/QStringList>
 
+#include "BookManipulation/XhtmlDoc.h"
 #include "Importers/Importer.h"
 #include "Misc/TempFolder.h"
 
@@ -57,6 +58,29 @@ private:
      */
     void ExtractContainer();
 
+    /**
+     * An entry of the EPUB zip waiting to be extracted.
+     */
+    struct ZipEntry {
+        // position of the entry in the central directory
+        quint64 pos_in_zip_directory;
+        quint64 num_of_file;
+        QString file_name;
+        QString cp437_file_name;
+        qint64 compressed_size;
+    };
+
+    /**
+     * Extracts a run of entries with its own handle on the zip.
+     * Runs on a worker thread.
+     *
+     * @param entries All entries to extract.
+     * @param start The first entry of the run.
+     * @param end One past the last entry of the run.
+     * @return An error message, empty if all entries were extracted.
+     */
+    QString ExtractZipEntries(const QList<ZipEntry> &entries, int start, int end);
+
     /**
      * Locates the OPF file in the extracted folder.
      * The path to the OPF is then stored in m_OPFFilePath.
@@ -113,16 +137,58 @@ private:
      */
     bool LoadFolderStructure();
 
+    /**
+     * Returns the epub root relative path of an opf relative href.
+     */
+    QString ExtractedBookPath(const QString &path) const;
+
     /**
      * Loads a single file.
      *
      * @param path A full path to the file to load.
      * @param mimetype The mimetype of the file to load.
+     * @param move_file Whether the extracted file can be moved into the book
+     *                  instead of being copied.
      * @return A tuple where the first member is the old path to the file,
      *         and the new member is the new, OEBPS-relative path to it.
      */
     std::tuple<QString, QString> LoadOneFile(const QString &path,
-                                        const QString &mimetype = QString());
+                                        const QString &mimetype = QString(),
+                                        bool move_file = false);
+
+    /**
+     * The result of reading and checking one html file on import.
+     */
+    struct HTMLValidation {
+        HTMLResource *resource;
+        QString text;
+        bool loaded;
+        XhtmlDoc::WellFormedError error;
+        qint64 nsecs;
+    };
+
+    /**
+     * Reads all html files in parallel and, if the check is wanted,
+     * finds their well-formed errors. Each file is read and checked once
+     * and the text is loaded into its resource.
+     *
+     * @param resources All the resources of the book.
+     * @param check Whether the well-formedness should be checked.
+     * @return One result per html file.
+     */
+    QList<HTMLValidation> ValidateHTMLFiles(const QList<Resource *> &resources, bool check);
+
+    /**
+     * Reads a single html file and checks it. Runs on a worker thread
+     * so the resource itself is left alone.
+     */
+    static HTMLValidation ValidateOneHTMLFile(HTMLResource *html_resource, bool check);
+
+    /**
+     * Mends a single html file. Runs on a worker thread
+     * and returns the mended text.
+     */
+    static std::pair<HTMLResource *, QString> MendOneHTMLFile(HTMLResource *html_resource);
 
     /**
      * Performs the necessary modifications to the OPF
@@ -209,6 +275,13 @@ private:
 
     QSet<QString> m_ZipFilePaths;
 
+    /**
+     * Entries whose name is not flagged as utf-8 are extracted under both
+     * their utf-8 and their CP437 reading. This maps each of the two
+     * epub root relative paths to the other one.
+     */
+    QHash<QString, QString> m_CP437Aliases;
+
     QDir m_opfDir;
 
     /**
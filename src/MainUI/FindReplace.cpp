@@ -480,6 +480,7 @@ void FindReplace::clearMessage()
 {
     if (!m_IsSearchGroupRunning) {
         ui.message->clear();
+        ui.message->setToolTip(QString());
         emit ShowMessageRequest("");
     }
 }
@@ -488,6 +489,7 @@ void FindReplace::expireMessage()
 {
     m_timer.stop();
     ui.message->clear();
+    ui.message->setToolTip(QString());
     emit ShowMessageRequest("");
 }
 
@@ -633,12 +635,17 @@ void FindReplace::CannotFindSearchTerm()
 // Constructs a searching regex from the selected
 // options and fields and then returns it.
 QString FindReplace::GetSearchRegex()
+{
+    return GetSearchRegex(ui.cbFind->lineEdit()->text());
+}
+
+QString FindReplace::GetSearchRegex(const QString &find_text)
 {
     if (m_SpellCheck) {
         return QString();
     }
 
-    QString text = ui.cbFind->lineEdit()->text();
+    QString text = find_text;
     // Convert &#x2029; to match line separator used by plainText.
     text.replace(QRegularExpression("\\R"), "\n");
 
@@ -757,6 +764,66 @@ int FindReplace::CountInFiles()
 }
 
 
+bool FindReplace::CanRunSearchGroupInFiles()
+{
+    // Everything else depends on the state of the current file (marked
+    // text, caret position or the spellchecker) so each search has to be
+    // run on its own.
+    return !m_SpellCheck &&
+           !m_LookWhereCurrentFile &&
+           m_OptionWrap &&
+           !IsMarkedText() &&
+           (GetLookWhere() == FindReplace::LookWhere_AllHTMLFiles ||
+            GetLookWhere() == FindReplace::LookWhere_SelectedHTMLFiles);
+}
+
+
+QList<SearchOperations::SearchStep> FindReplace::GetSearchGroupSteps(QList<SearchEditorModel::searchEntry *> search_entries, QStringList &names)
+{
+    QList<SearchOperations::SearchStep> steps;
+    foreach(SearchEditorModel::searchEntry * search_entry, search_entries) {
+        UpdatePreviousFindStrings(search_entry->find);
+        UpdatePreviousReplaceStrings(search_entry->replace);
+
+        if (!search_entry->find.isEmpty()) {
+            SearchOperations::SearchStep step;
+            step.search_regex = GetSearchRegex(search_entry->find);
+            step.replacement = search_entry->replace;
+            steps.append(step);
+            names.append(search_entry->name.isEmpty() ? tr("Unnamed search") : search_entry->name);
+        }
+
+        delete search_entry;
+    }
+    return steps;
+}
+
+
+QStringList FindReplace::ShowSearchGroupCounts(const QStringList &names, const QVector<int> &counts)
+{
+    QStringList lines;
+    QStringList invalid_names;
+    for (int i = 0; i < names.count() && i < counts.count(); i++) {
+        if (counts.at(i) < 0) {
+            lines.append(QString("%1: %2").arg(names.at(i).toHtmlEscaped()).arg(tr("invalid regular expression")));
+            invalid_names.append(names.at(i));
+        } else {
+            lines.append(QString("%1: %2").arg(names.at(i).toHtmlEscaped()).arg(counts.at(i)));
+        }
+    }
+    ui.message->setToolTip(lines.join("<br/>"));
+    return invalid_names;
+}
+
+
+void FindReplace::ShowInvalidSearches(const QStringList &names)
+{
+    if (!names.isEmpty()) {
+        ShowMessage(tr("Invalid regular expression in: %1").arg(names.join(", ")));
+    }
+}
+
+
 int FindReplace::ReplaceInAllFiles(bool exclude_html_tag)
 {
     // For now, this must hold
@@ -1259,13 +1326,31 @@ void FindReplace::CountAllSearch(QList<SearchEditorModel::searchEntry *> search_
     }
 
     SetKeyModifiers();
-    m_IsSearchGroupRunning = true;
     int count = 0;
-    foreach(SearchEditorModel::searchEntry * search_entry, search_entries) {
-        LoadSearch(search_entry);
-        count += Count();
+    QStringList invalid_names;
+
+    if (CanRunSearchGroupInFiles()) {
+        clearMessage();
+        m_MainWindow->GetCurrentContentTab()->SaveTabContent();
+        SetCodeViewIfNeeded(true);
+        QStringList names;
+        QList<SearchOperations::SearchStep> steps = GetSearchGroupSteps(search_entries, names);
+        QVector<int> counts = SearchOperations::CountInFiles(steps,
+                                                             GetHTMLFiles(),
+                                                             SearchOperations::CodeViewSearch,
+                                                             GetSearchMode() == FindReplace::SearchMode_Text);
+        foreach(int step_count, counts) {
+            count += qMax(step_count, 0);
+        }
+        invalid_names = ShowSearchGroupCounts(names, counts);
+    } else {
+        m_IsSearchGroupRunning = true;
+        foreach(SearchEditorModel::searchEntry * search_entry, search_entries) {
+            LoadSearch(search_entry);
+            count += Count();
+        }
+        m_IsSearchGroupRunning = false;
     }
-    m_IsSearchGroupRunning = false;
 
     if (count == 0) {
         CannotFindSearchTerm();
@@ -1274,6 +1359,7 @@ void FindReplace::CountAllSearch(QList<SearchEditorModel::searchEntry *> search_
         ShowMessage(message);
     }
 
+    ShowInvalidSearches(invalid_names);
     ResetKeyModifiers();
 }
 
@@ -1285,13 +1371,36 @@ void FindReplace::ReplaceAllSearch(QList<SearchEditorModel::searchEntry *> searc
     }
 
     SetKeyModifiers();
-    m_IsSearchGroupRunning = true;
     int count = 0;
-    foreach(SearchEditorModel::searchEntry * search_entry, search_entries) {
-        LoadSearch(search_entry);
-        count += ReplaceAll();
+    QStringList invalid_names;
+
+    if (CanRunSearchGroupInFiles()) {
+        clearMessage();
+        m_MainWindow->GetCurrentContentTab()->SaveTabContent();
+        SetCodeViewIfNeeded(true);
+        QStringList names;
+        QList<SearchOperations::SearchStep> steps = GetSearchGroupSteps(search_entries, names);
+        QVector<int> counts = SearchOperations::ReplaceInAllFIles(steps,
+                                                                  GetHTMLFiles(),
+                                                                  SearchOperations::CodeViewSearch,
+                                                                  GetSearchMode() == FindReplace::SearchMode_Text);
+        foreach(int step_count, counts) {
+            count += qMax(step_count, 0);
+        }
+        invalid_names = ShowSearchGroupCounts(names, counts);
+
+        if (count > 0) {
+            m_MainWindow->GetCurrentBook()->SetModified(true);
+            m_MainWindow->GetCurrentContentTab()->ContentChangedExternally();
+        }
+    } else {
+        m_IsSearchGroupRunning = true;
+        foreach(SearchEditorModel::searchEntry * search_entry, search_entries) {
+            LoadSearch(search_entry);
+            count += ReplaceAll();
+        }
+        m_IsSearchGroupRunning = false;
     }
-    m_IsSearchGroupRunning = false;
 
     if (count == 0) {
         ShowMessage(tr("No replacements made"));
@@ -1300,6 +1409,7 @@ void FindReplace::ReplaceAllSearch(QList<SearchEditorModel::searchEntry *> searc
         ShowMessage(message);
     }
 
+    ShowInvalidSearches(invalid_names);
     ResetKeyModifiers();
 }
 
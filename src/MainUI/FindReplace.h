@@ -193,6 +193,7 @@ private:
     // Constructs a searching regex from the selected
     // options and fields and then returns it.
     QString GetSearchRegex();
+    QString GetSearchRegex(const QString &find_text);
     QString PrependRegexOptionToSearch(const QString &option, const QString &search);
 
     QList <Resource *> GetHTMLFiles();
@@ -207,6 +208,35 @@ private:
 
     int ReplaceInAllFiles(bool exclude_html_tag);
 
+    /**
+     * Can a search group be run over all of the files in one pass
+     * instead of running its searches one at a time.
+     */
+    bool CanRunSearchGroupInFiles();
+
+    /**
+     * Converts the entries of a search group into the steps used by
+     * SearchOperations. The entries are added to the find and replace
+     * history like loading them would and are then deleted.
+     *
+     * @param[out] names The name of each step.
+     */
+    QList<SearchOperations::SearchStep> GetSearchGroupSteps(QList<SearchEditorModel::searchEntry *> search_entries, QStringList &names);
+
+    /**
+     * Lists the count of each step of a search group in the tooltip
+     * of the message.
+     *
+     * @return The names of the steps whose pattern is not a valid regex.
+     */
+    QStringList ShowSearchGroupCounts(const QStringList &names, const QVector<int> &counts);
+
+    /**
+     * Tells the user which searches of a group could not be run
+     * because their pattern is not a valid regex.
+     */
+    void ShowInvalidSearches(const QStringList &names);
+
     bool FindInAllFiles(Searchable::Direction direction);
 
     HTMLResource *GetNextContainingHTMLResource(Searchable::Direction direction);
@@ -90,7 +90,6 @@
 #include "Misc/OpenExternally.h"
 #include "Misc/Plugin.h"
 #include "Misc/PluginDB.h"
-#include "Misc/PythonRoutines.h"
 #include "Misc/SettingsStore.h"
 #include "Misc/SleepFunctions.h"
 #include "Misc/SpellCheck.h"
@@ -1761,16 +1760,10 @@ void MainWindow::GenerateNCXGuideFromNav()
 
     // find existing nav document if there is one
     HTMLResource * nav_resource = m_Book->GetConstOPF()->GetNavResource();
-    QString navbkpath = "";
-    QString navdata = "";
-    if (nav_resource) {
-        navdata = CleanSource::Mend(nav_resource->GetText(),"3.0");
-        navbkpath = nav_resource->GetRelativePath();
-    }
-
-    if ((!nav_resource) || navdata.isEmpty()) {
+    if (!nav_resource) {
         ShowMessageOnStatusBar(tr("NCX and Guide generation failed."));
         QApplication::restoreOverrideCursor();
+        return;
     }
 
     NCXResource * ncx_resource = m_Book->GetNCX();
@@ -1784,29 +1777,8 @@ void MainWindow::GenerateNCXGuideFromNav()
 	m_Book->GetOPF()->UpdateNCXOnSpine(NCXId);
     }
 
-    QString ncxdir = Utility::startingDir(ncx_resource->GetRelativePath());
-
-    QList<QVariant> mvalues = m_Book->GetConstOPF()->GetDCMetadataValues("dc:title");
-    QString doctitle = "UNKNOWN";
-    if (!mvalues.isEmpty()) {
-        doctitle = mvalues.at(0).toString();
-    } 
-    QString mainid = m_Book->GetConstOPF()->GetMainIdentifierValue();
-
-    // Now build the ncx in python in a separate thread since may be an long job
-    PythonRoutines pr;
-    QFuture<QString> future = QtConcurrent::run(&pr, &PythonRoutines::GenerateNcxInPython, navdata, 
-						navbkpath, ncxdir, doctitle, mainid);
-    future.waitForFinished();
-    QString ncxdata = future.result();
-
-    if (ncxdata.isEmpty()) {
-        ShowMessageOnStatusBar(tr("NCX and Guide generation failed."));
-        QApplication::restoreOverrideCursor();
-        return;
-    }
-
-    ncx_resource->SetText(ncxdata);
+    // Now build the ncx from the nav toc and page-list
+    ncx_resource->GenerateNCXFromNav(m_Book.data(), nav_resource);
     ncx_resource->SaveToDisk();
 
     // now create the opf guide from the nav
@@ -204,23 +204,7 @@ QString CSSInfo::getReformattedCSSText(bool multipleLineFormat)
         // an error happened, return unchanged original
         return QString(csstext);
     }
-    // QVariant results are a String List (new_css_text, errors, warnings)
-    QStringList results = res.toStringList();
-    QString new_csstext = results[0];
-    QString errors = results[1];
-    QString warnings = results[2];
-
-    if (!errors.isEmpty()) {
-        Utility::DisplayStdWarningDialog(QString("Error in cssreformatter: "), errors);
-        // an error happened, return unchanged original
-        return QString(csstext);
-    }
-
-    if (!warnings.isEmpty()) {
-        Utility::DisplayStdWarningDialog(QString("Warnings from cssreformatter: "), warnings);
-    }
-
-    return new_csstext;
+    return reformattedCSSTextFromResult(csstext, res);
 
 #if 0  // attempt to replace out broken css reformatter with a python one based on css_parser
     int selector_indent = m_IsCSSFile ? 0 : TAB_SPACES_WIDTH;
@@ -297,6 +281,45 @@ QString CSSInfo::getReformattedCSSText(bool multipleLineFormat)
 #endif
 }
 
+QFuture<QVariant> CSSInfo::reformatCSSTextAsync(const QString &csstext, bool multipleLineFormat)
+{
+    // See getReformattedCSSText for the int instead of bool
+    int useoneline = 1;
+    if (multipleLineFormat) useoneline = 0;
+
+    QList<QVariant> args;
+    args.append(QVariant(csstext));
+    args.append(QVariant(useoneline));
+    EmbeddedPython * epython  = EmbeddedPython::instance();
+    return epython->runInPythonAsync(QString("cssreformatter"), QString("reformat_css"), args);
+}
+
+QString CSSInfo::reformattedCSSTextFromResult(const QString &csstext, const QVariant &res)
+{
+    if (!res.isValid()) {
+        // the python worker printed the traceback
+        Utility::DisplayStdWarningDialog(QString("Error in cssreformatter"));
+        return QString(csstext);
+    }
+    // QVariant results are a String List (new_css_text, errors, warnings)
+    QStringList results = res.toStringList();
+    QString new_csstext = results[0];
+    QString errors = results[1];
+    QString warnings = results[2];
+
+    if (!errors.isEmpty()) {
+        Utility::DisplayStdWarningDialog(QString("Error in cssreformatter: "), errors);
+        // an error happened, return unchanged original
+        return QString(csstext);
+    }
+
+    if (!warnings.isEmpty()) {
+        Utility::DisplayStdWarningDialog(QString("Warnings from cssreformatter: "), warnings);
+    }
+
+    return new_csstext;
+}
+
 QString CSSInfo::removeMatchingSelectors(QList<CSSSelector *> cssSelectors)
 {
     // First try to find a CSS selector currently parsed that matches each of the selectors supplied.
@@ -26,8 +26,10 @@
 #ifndef CSSINFO_H
 #define CSSINFO_H
 
+#include <QtCore/QFuture>
 #include <QtCore/QObject>
 #include <QtCore/QStringList>
+#include <QtCore/QVariant>
 
 class QStringList;
 
@@ -96,6 +98,20 @@ public:
      */
     QString getReformattedCSSText(bool multipleLineFormat);
 
+    /**
+     * Starts reformatting csstext on the python worker thread the same
+     * way as getReformattedCSSText and returns without waiting for it.
+     * Pass the result to reformattedCSSTextFromResult.
+     */
+    static QFuture<QVariant> reformatCSSTextAsync(const QString &csstext, bool multipleLineFormat);
+
+    /**
+     * Return the reformatted text from the result of reformatCSSTextAsync,
+     * or csstext unchanged on errors. Shows the errors and warnings of
+     * the reformatter, so must be called on the GUI thread.
+     */
+    static QString reformattedCSSTextFromResult(const QString &csstext, const QVariant &res);
+
     /**
      * Search for a CSSSelector with the same definition of original group text and line as this,
      * and if found remove from the document text, returning the new text.
@@ -29,6 +29,10 @@
 #include <QMetaType>
 #include <QStandardPaths>
 #include <QDir>
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QThread>
+#include <algorithm>
 #include "Misc/Utility.h"
 #include "sigil_constants.h"
 
@@ -167,6 +171,30 @@ QMutex EmbeddedPython::m_mutex;
 EmbeddedPython* EmbeddedPython::m_instance = 0;
 int EmbeddedPython::m_pyobjmetaid = 0;
 PyThreadState * EmbeddedPython::m_threadstate = NULL;
+QHash<QString, PyObject *> EmbeddedPython::m_modulecache;
+QHash<QString, PyObject *> EmbeddedPython::m_callablecache;
+QHash<QString, EmbeddedPython::CallStatistics> EmbeddedPython::m_callstatistics;
+QMutex EmbeddedPython::m_queuemutex;
+QWaitCondition EmbeddedPython::m_queuecondition;
+QQueue<EmbeddedPython::PythonRequest> EmbeddedPython::m_queue;
+QThread *EmbeddedPython::m_worker = NULL;
+bool EmbeddedPython::m_stopworker = false;
+
+namespace
+{
+    // the thread that runs all asynchronous requests in order
+    class PythonWorker : public QThread
+    {
+    public:
+        PythonWorker(EmbeddedPython *epython) : m_epython(epython) {}
+
+    protected:
+        void run() { m_epython->processRequests(); }
+
+    private:
+        EmbeddedPython *m_epython;
+    };
+}
 
 EmbeddedPython* EmbeddedPython::instance()
 {
@@ -227,7 +255,9 @@ EmbeddedPython::~EmbeddedPython()
         m_instance = 0;
     }
     m_pyobjmetaid = 0;
+    stopWorker();
     PyEval_RestoreThread(m_threadstate);
+    clearCallableCacheLocked();
     Py_Finalize();
 }
 
@@ -281,6 +311,8 @@ bool EmbeddedPython::addToPythonSysPath(const QString &mpath)
         }
     }
     Py_XDECREF(aPath);
+    // modules may now resolve to something else
+    clearCallableCacheLocked();
     PyGILState_Release(gstate);
     EmbeddedPython::m_mutex.unlock();
     return success;
@@ -297,69 +329,124 @@ QVariant EmbeddedPython::runInPython(const QString &mname,
 {
     EmbeddedPython::m_mutex.lock();
     PyGILState_STATE gstate = PyGILState_Ensure();
-        
-    QVariant  res        = QVariant(QString());
-    PyObject *moduleName = NULL;
-    PyObject *module     = NULL;
-    PyObject *func       = NULL;
-    PyObject *pyargs     = NULL;
-    PyObject *pyres      = NULL;
-    int       idx        = 0;
+    QVariant res = runInPythonLocked(mname, fname, args, rv, tb, ret_python_object, true);
+    PyGILState_Release(gstate);
+    EmbeddedPython::m_mutex.unlock();
+    return res;
+}
 
-    moduleName = PyUnicode_FromString(mname.toUtf8().constData());
-    if (moduleName == NULL) {
-        *rv = -1;
-        goto cleanup;
-    }
 
-    module = PyImport_Import(moduleName);
-    if (module == NULL) {
-        *rv = -2;
-        goto cleanup;
+QFuture<QVariant> EmbeddedPython::runInPythonAsync(const QString &mname,
+                                                   const QString &fname,
+                                                   const QVariantList &args,
+                                                   bool ret_python_object)
+{
+    PythonRequest request;
+    request.module_name = mname;
+    request.function_name = fname;
+    request.args = args;
+    request.ret_python_object = ret_python_object;
+    request.future.reportStarted();
+    QFuture<QVariant> future = request.future.future();
+
+    QMutexLocker locker(&m_queuemutex);
+    m_queue.enqueue(request);
+    if (!m_worker) {
+        m_worker = new PythonWorker(this);
+        m_worker->start();
     }
+    m_queuecondition.wakeOne();
+    return future;
+}
 
-    func = PyObject_GetAttrString(module,fname.toUtf8().constData());
-    if (func == NULL) {
-        *rv = -3;
-        goto cleanup;
-    }
 
-    if (!PyCallable_Check(func)) {
-        *rv = -4;
-        goto cleanup;
+// runs on the python worker thread until stopWorker() is called
+void EmbeddedPython::processRequests()
+{
+    forever {
+        QQueue<PythonRequest> batch;
+        {
+            QMutexLocker locker(&m_queuemutex);
+            while (m_queue.isEmpty() && !m_stopworker) {
+                m_queuecondition.wait(&m_queuemutex);
+            }
+            if (m_queue.isEmpty()) {
+                return;
+            }
+            // take everything queued so far and run it under one GIL acquisition
+            batch.swap(m_queue);
+        }
+        EmbeddedPython::m_mutex.lock();
+        PyGILState_STATE gstate = PyGILState_Ensure();
+        while (!batch.isEmpty()) {
+            PythonRequest request = batch.dequeue();
+            int rv = 0;
+            QString tb;
+            QVariant res = runInPythonLocked(request.module_name, request.function_name, request.args,
+                                             &rv, tb, request.ret_python_object, false);
+            if (rv != 0) {
+                qWarning().noquote() << request.module_name + "." + request.function_name << "error" << rv
+                                     << "traceback" << tb;
+                // callers can tell a failed request by its invalid result
+                res = QVariant();
+            }
+            request.future.reportResult(res);
+            request.future.reportFinished();
+        }
+        PyGILState_Release(gstate);
+        EmbeddedPython::m_mutex.unlock();
     }
+}
 
-    // Build up Python argument List from args
-    pyargs = PyTuple_New(args.size());
-    idx = 0;
-    foreach(QVariant arg, args) {
-        PyTuple_SetItem(pyargs, idx, QVariantToPyObject(arg));
-        idx++;
-    }
 
-    pyres = PyObject_CallObject(func, pyargs);
-    if (pyres == NULL) {
-        *rv = -5;
-        goto cleanup;
+void EmbeddedPython::stopWorker()
+{
+    {
+        QMutexLocker locker(&m_queuemutex);
+        if (!m_worker) {
+            return;
+        }
+        m_stopworker = true;
+        m_queuecondition.wakeOne();
     }
+    // queued requests are still run before the worker exits
+    m_worker->wait();
+    delete m_worker;
+    m_worker = NULL;
+    m_stopworker = false;
+}
 
-    *rv = 0;
 
-    res = PyObjectToQVariant(pyres, ret_python_object);
+QString EmbeddedPython::callStatisticsReport()
+{
+    EmbeddedPython::m_mutex.lock();
+    QHash<QString, CallStatistics> stats = m_callstatistics;
+    EmbeddedPython::m_mutex.unlock();
 
-cleanup:
-    if (PyErr_Occurred() != NULL) {
-        tb = getPythonErrorTraceback();
+    QList<QString> keys = stats.keys();
+    std::sort(keys.begin(), keys.end(), [&stats](const QString &a, const QString &b) {
+        return stats.value(a).nsecs > stats.value(b).nsecs;
+    });
+    QStringList report;
+    report << QString("%1 %2 %3 %4").arg("Python function", -50).arg("calls", 10)
+                                    .arg("total ms", 12).arg("mean ms", 10);
+    foreach(QString key, keys) {
+        const CallStatistics &cs = stats[key];
+        report << QString("%1 %2 %3 %4").arg(key, -50).arg(cs.calls, 10)
+                                        .arg(cs.nsecs / 1000000.0, 12, 'f', 1)
+                                        .arg(cs.nsecs / 1000000.0 / cs.calls, 10, 'f', 3);
     }
-    Py_XDECREF(pyres);
-    Py_XDECREF(pyargs);
-    Py_XDECREF(func);
-    Py_XDECREF(module);
-    Py_XDECREF(moduleName);
+    return report.join("\n");
+}
+
 
+void EmbeddedPython::clearCallableCache()
+{
+    EmbeddedPython::m_mutex.lock();
+    PyGILState_STATE gstate = PyGILState_Ensure();
+    clearCallableCacheLocked();
     PyGILState_Release(gstate);
     EmbeddedPython::m_mutex.unlock();
-    return res;
 }
 
 
@@ -374,6 +461,8 @@ QVariant EmbeddedPython::callPyObjMethod(PyObjectPtr &pyobj,
 {
     EmbeddedPython::m_mutex.lock();
     PyGILState_STATE gstate = PyGILState_Ensure();
+    QElapsedTimer timer;
+    timer.start();
 
     QVariant  res        = QVariant(QString());
     PyObject* obj        = pyobj.object();
@@ -419,6 +508,7 @@ QVariant EmbeddedPython::callPyObjMethod(PyObjectPtr &pyobj,
     Py_XDECREF(pyargs);
     Py_XDECREF(func);
 
+    recordCall(QString(Py_TYPE(obj)->tp_name) + "." + methname, timer.nsecsElapsed());
     PyGILState_Release(gstate);
     EmbeddedPython::m_mutex.unlock();
     return res;
@@ -428,6 +518,186 @@ QVariant EmbeddedPython::callPyObjMethod(PyObjectPtr &pyobj,
 // *** below here all routines are private and only invoked 
 // *** from runInPython and callPyObjMethod with lock held
 
+QVariant EmbeddedPython::runInPythonLocked(const QString &mname, 
+                                           const QString &fname, 
+                                           const QVariantList &args, 
+                                           int *rv, 
+                                           QString &tb,
+                                           bool ret_python_object,
+                                           bool useMsgBox)
+{
+    QElapsedTimer timer;
+    timer.start();
+        
+    QVariant  res        = QVariant(QString());
+    PyObject *func       = NULL;
+    PyObject *pyargs     = NULL;
+    PyObject *pyres      = NULL;
+    int       idx        = 0;
+
+    func = getCallable(mname, fname, rv);
+    if (func == NULL) {
+        goto cleanup;
+    }
+
+    // Build up Python argument List from args
+    pyargs = PyTuple_New(args.size());
+    idx = 0;
+    foreach(QVariant arg, args) {
+        PyTuple_SetItem(pyargs, idx, QVariantToPyObject(arg));
+        idx++;
+    }
+
+    pyres = PyObject_CallObject(func, pyargs);
+    if (pyres == NULL) {
+        *rv = -5;
+        goto cleanup;
+    }
+
+    *rv = 0;
+
+    res = PyObjectToQVariant(pyres, ret_python_object);
+
+cleanup:
+    if (PyErr_Occurred() != NULL) {
+        tb = getPythonErrorTraceback(useMsgBox);
+    }
+    Py_XDECREF(pyres);
+    Py_XDECREF(pyargs);
+    Py_XDECREF(func);
+
+    recordCall(mname + "." + fname, timer.nsecsElapsed());
+    return res;
+}
+
+
+// returns a new reference to the function or NULL with rv set
+// modules and functions are cached as importing is the expensive part
+// of a call for the small helpers that get called thousands of times
+PyObject *EmbeddedPython::getCallable(const QString &mname, const QString &fname, int *rv)
+{
+    QString key = mname + "." + fname;
+    PyObject *func = m_callablecache.value(key, NULL);
+    if (func != NULL) {
+        Py_INCREF(func);
+        return func;
+    }
+
+    PyObject *module = m_modulecache.value(mname, NULL);
+    if (module == NULL) {
+        PyObject *moduleName = PyUnicode_FromString(mname.toUtf8().constData());
+        if (moduleName == NULL) {
+            *rv = -1;
+            return NULL;
+        }
+        module = PyImport_Import(moduleName);
+        Py_DECREF(moduleName);
+        if (module == NULL) {
+            *rv = -2;
+            return NULL;
+        }
+        m_modulecache.insert(mname, module);
+    }
+
+    func = PyObject_GetAttrString(module,fname.toUtf8().constData());
+    if (func == NULL) {
+        *rv = -3;
+        return NULL;
+    }
+
+    if (!PyCallable_Check(func)) {
+        Py_DECREF(func);
+        *rv = -4;
+        return NULL;
+    }
+
+    Py_INCREF(func);
+    m_callablecache.insert(key, func);
+    return func;
+}
+
+
+void EmbeddedPython::clearCallableCacheLocked()
+{
+    foreach(PyObject *func, m_callablecache) {
+        Py_DECREF(func);
+    }
+    m_callablecache.clear();
+    foreach(PyObject *module, m_modulecache) {
+        Py_DECREF(module);
+    }
+    m_modulecache.clear();
+}
+
+
+void EmbeddedPython::recordCall(const QString &key, qint64 nsecs)
+{
+    CallStatistics &cs = m_callstatistics[key];
+    cs.calls++;
+    cs.nsecs += nsecs;
+}
+
+
+
+// Strings are copied straight into the storage kind python (PEP 393) or Qt
+// will use, with the lengths known up front. One pass over a QString finds the
+// widest character so no utf-8 encode/decode or terminator scans are needed.
+PyObject *EmbeddedPython::QStringToPyUnicode(const QString &str)
+{
+    const ushort *data = str.utf16();
+    const Py_ssize_t len = str.size();
+    ushort maxchar = 0;
+    bool has_surrogates = false;
+    for (Py_ssize_t i = 0; i < len; i++) {
+        ushort c = data[i];
+        if (c > maxchar) maxchar = c;
+        if ((c & 0xF800) == 0xD800) has_surrogates = true;
+    }
+
+    if (has_surrogates) {
+        // Let python pair up the surrogates, lone ones are replaced
+        // as the utf-8 route used to do
+        int byteorder = (Q_BYTE_ORDER == Q_LITTLE_ENDIAN) ? -1 : 1;
+        return PyUnicode_DecodeUTF16(reinterpret_cast<const char *>(data), len * 2, "replace", &byteorder);
+    }
+
+    PyObject *pystr = PyUnicode_New(len, maxchar);
+    if (pystr == NULL) {
+        return NULL;
+    }
+    if (PyUnicode_KIND(pystr) == PyUnicode_1BYTE_KIND) {
+        Py_UCS1 *dest = PyUnicode_1BYTE_DATA(pystr);
+        for (Py_ssize_t i = 0; i < len; i++) {
+            dest[i] = static_cast<Py_UCS1>(data[i]);
+        }
+    } else {
+        memcpy(PyUnicode_2BYTE_DATA(pystr), data, len * sizeof(Py_UCS2));
+    }
+    return pystr;
+}
+
+
+QString EmbeddedPython::PyUnicodeToQString(PyObject *po)
+{
+    if (PyUnicode_READY(po) != 0) {
+        return QString();
+    }
+    const Py_ssize_t len = PyUnicode_GET_LENGTH(po);
+    switch (PyUnicode_KIND(po)) {
+        case PyUnicode_1BYTE_KIND:
+            // latin 1 according to PEP 393
+            return QString::fromLatin1(reinterpret_cast<const char *>(PyUnicode_1BYTE_DATA(po)), len);
+        case PyUnicode_2BYTE_KIND:
+            // same layout as QChar, fromUtf16 would also drop a leading BOM
+            return QString(reinterpret_cast<const QChar *>(PyUnicode_2BYTE_DATA(po)), len);
+        case PyUnicode_4BYTE_KIND:
+            return QString::fromUcs4(PyUnicode_4BYTE_DATA(po), len);
+        default:
+            // convert to utf8 since not a known kind
+            return QString::fromUtf8(PyUnicode_AsUTF8(po), -1);
+    }
+}
+
 
 // Convert PyObject types to their QVariant equivalents 
 // call recursively to allow populating QVariant lists and lists of lists
@@ -448,27 +718,7 @@ QVariant EmbeddedPython::PyObjectToQVariant(PyObject *po, bool ret_python_object
         res = QVariant(QByteArray(PyBytes_AsString(po)));
 
     } else if (PyUnicode_Check(po)) {
-
-        int kind = PyUnicode_KIND(po);
-
-        if (PyUnicode_READY(po) != 0)
-            return res;
-
-        if (kind == PyUnicode_1BYTE_KIND) {
-            // latin 1 according to PEP 393
-            res = QVariant(QString::fromLatin1(reinterpret_cast<const char *>PyUnicode_1BYTE_DATA(po), -1));
-
-        } else if (kind == PyUnicode_2BYTE_KIND) {
-            res = QVariant(QString::fromUtf16(PyUnicode_2BYTE_DATA(po), -1));
-
-        } else if (kind == PyUnicode_4BYTE_KIND) {
-            // PyUnicode_4BYTE_KIND
-            res = QVariant(QString::fromUcs4(PyUnicode_4BYTE_DATA(po), -1));
-
-        } else {
-            // convert to utf8 since not a known
-            res = QVariant(QString::fromUtf8(PyUnicode_AsUTF8(po),-1));
-        }
+        res = QVariant(PyUnicodeToQString(po));
 
     } else if (PyTuple_Check(po)) {
         QVariantList vlist;
@@ -522,10 +772,7 @@ PyObject* EmbeddedPython::QVariantToPyObject(const QVariant &v)
             value = Py_BuildValue("K", v.toULongLong(&ok));
             break;
         case QMetaType::QString:
-            // since QString's utf-16 may contain surrogates or may only be pure ascii we have no easy
-            // to know the proper string storage type to use internal to python (latin1, ucs2, ucs4)
-            // so punt and create utf-8 and let python handle the conversion internally via its c-api
-            value = Py_BuildValue("s", v.toString().toUtf8().constData());
+            value = QStringToPyUnicode(v.toString());
             break;
         case QMetaType::QByteArray:
             value = Py_BuildValue("y", v.toByteArray().constData());
@@ -536,10 +783,7 @@ PyObject* EmbeddedPython::QVariantToPyObject(const QVariant &v)
               value = PyList_New(vlist.size());
               int pos = 0;
               foreach(QString av, vlist) {
-                  // since QString's utf-16 may contain surrogates or may only be pure ascii we have no easy
-                  // to know the proper string storage type to use internal to python (latin1, ucs2, ucs4)
-                  // so punt and create utf-8 and let python handle the conversion internally via its c-api
-                  PyObject* strval = Py_BuildValue("s", av.toUtf8().constData());
+                  PyObject* strval = QStringToPyUnicode(av);
                   PyList_SetItem(value, pos, strval);
                   pos++;
                }
@@ -28,8 +28,15 @@
 #include <QString>
 #include <QVariant>
 #include <QMutex>
+#include <QHash>
+#include <QQueue>
+#include <QFuture>
+#include <QFutureInterface>
+#include <QWaitCondition>
 #include "Misc/PyObjectPtr.h"
 
+class QThread;
+
 /**
  * Singleton.
  */
@@ -54,6 +61,24 @@ public:
                          QString &error_traceback,
                          bool ret_python_object = false);
 
+    /**
+     * Queues a call for the python worker thread and returns at once.
+     * All requests that are waiting when the worker wakes up run
+     * under a single lock and GIL acquisition, in submission order.
+     *
+     * @return A future for the result. The result is an invalid
+     *         QVariant if the call failed, the traceback is printed.
+     */
+    QFuture<QVariant> runInPythonAsync(const QString &module_name,
+                                       const QString &function_name,
+                                       const QVariantList &args,
+                                       bool ret_python_object = false);
+
+    /**
+     * The python worker thread's loop. Not to be called directly.
+     */
+    void processRequests();
+
     QVariant callPyObjMethod(PyObjectPtr &pyobj, 
                              const QString &methname, 
                              const QVariantList &args, 
@@ -61,6 +86,18 @@ public:
                              QString &tb,
                              bool ret_python_object = false);
 
+    /**
+     * Returns a table of how often each python function and method
+     * was called and how much time was spent running it.
+     */
+    QString callStatisticsReport();
+
+    /**
+     * Drops all cached modules and functions so the next call imports
+     * them again. Done automatically whenever sys.path changes.
+     */
+    void clearCallableCache();
+
 private:
 
     EmbeddedPython();
@@ -69,11 +106,57 @@ private:
 
     PyObject *QVariantToPyObject(const QVariant &v);
 
+    PyObject *QStringToPyUnicode(const QString &str);
+
+    QString PyUnicodeToQString(PyObject *po);
+
     QString getPythonErrorTraceback(bool useMsgBox = true);
 
+    QVariant runInPythonLocked(const QString &module_name,
+                               const QString &function_name,
+                               const QVariantList &args,
+                               int *pRV,
+                               QString &error_traceback,
+                               bool ret_python_object,
+                               bool useMsgBox);
+
+    void stopWorker();
+
+    PyObject *getCallable(const QString &mname, const QString &fname, int *rv);
+
+    void clearCallableCacheLocked();
+
+    void recordCall(const QString &key, qint64 nsecs);
+
+    struct PythonRequest {
+        QString module_name;
+        QString function_name;
+        QVariantList args;
+        bool ret_python_object;
+        QFutureInterface<QVariant> future;
+    };
+
+    struct CallStatistics {
+        qint64 calls;
+        qint64 nsecs;
+        CallStatistics() : calls(0), nsecs(0) {}
+    };
+
     static QMutex m_mutex;
     static EmbeddedPython *m_instance;
     static int m_pyobjmetaid;
     static PyThreadState *m_threadstate;
+
+    // imported modules and resolved functions, all strong references
+    static QHash<QString, PyObject *> m_modulecache;
+    static QHash<QString, PyObject *> m_callablecache;
+    static QHash<QString, CallStatistics> m_callstatistics;
+
+    // requests for the python worker thread
+    static QMutex m_queuemutex;
+    static QWaitCondition m_queuecondition;
+    static QQueue<PythonRequest> m_queue;
+    static QThread *m_worker;
+    static bool m_stopworker;
 };
 #endif // EMBEDDEDPYTHON_H
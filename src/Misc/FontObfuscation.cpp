@@ -55,7 +55,7 @@ QByteArray AdobeKeyFromIdentifier(const QString &identifier)
 }
 
 
-void IdpfObfuscate(const QString &filepath, const QString &identifier)
+void ObfuscateContents(const QString &filepath, const QString &algorithm, const QByteArray &key)
 {
     QFile file(filepath);
 
@@ -64,66 +64,65 @@ void IdpfObfuscate(const QString &filepath, const QString &identifier)
     }
 
     QByteArray contents = file.readAll();
-    QByteArray key = IdpfKeyFromIdentifier(identifier);
-    int key_size   = key.size();
-    if (key_size == 0) {
-        return;
-    }
-
-    for (int i = 0; (i < IDPF_METHOD_NUM_BYTES) && (i < contents.size()); ++i) {
-        contents[ i ] = contents[ i ] ^ key[ i % key_size ];
-    }
-
+    FontObfuscation::ObfuscateBlock(contents.data(), contents.size(), 0, algorithm, key);
     file.seek(0);
     file.write(contents);
 }
 
+};
 
-void AdobeObfuscate(const QString &filepath, const QString &identifier)
-{
-    QFile file(filepath);
 
-    if (!file.open(QFile::ReadWrite)) {
-        return;
+void FontObfuscation::ObfuscateFile(const QString &filepath,
+                                    const QString &algorithm,
+                                    const QString &identifier)
+{
+    if (!QFileInfo(filepath).exists()) {
+        std::string msg = filepath.toStdString() + ": " + algorithm.toStdString() + ": " + identifier.toStdString();
+        throw(FontObfuscationError(msg));
     }
 
-    QByteArray contents = file.readAll();
-    QByteArray key = AdobeKeyFromIdentifier(identifier);
-    int key_size   = key.size();
-    if (key_size == 0) {
+    QByteArray key = KeyFromIdentifier(algorithm, identifier);
+    if (key.isEmpty()) {
         return;
     }
 
-    for (int i = 0; (i < ADOBE_METHOD_NUM_BYTES) && (i < contents.size()); ++i) {
-        contents[ i ] = contents[ i ] ^ key[ i % key_size ];
-    }
-
-    file.seek(0);
-    file.write(contents);
+    ObfuscateContents(filepath, algorithm, key);
 }
 
-};
-
 
-void FontObfuscation::ObfuscateFile(const QString &filepath,
-                                    const QString &algorithm,
-                                    const QString &identifier)
+QByteArray FontObfuscation::KeyFromIdentifier(const QString &algorithm,
+                                              const QString &identifier)
 {
-    if (!QFileInfo(filepath).exists() ||
-        algorithm.isEmpty()             ||
-        identifier.isEmpty()) {
-        std::string msg = filepath.toStdString() + ": " + algorithm.toStdString() + ": " + identifier.toStdString();
+    if (algorithm.isEmpty() || identifier.isEmpty()) {
+        std::string msg = algorithm.toStdString() + ": " + identifier.toStdString();
         throw(FontObfuscationError(msg));
     }
 
     if (algorithm == ADOBE_FONT_ALGO_ID) {
-        AdobeObfuscate(filepath, identifier);
+        return AdobeKeyFromIdentifier(identifier);
     } else if (algorithm == IDPF_FONT_ALGO_ID) {
-        IdpfObfuscate(filepath, identifier);
-    } else {
-        std::string msg = filepath.toStdString() + ": " + algorithm.toStdString() + ": " + identifier.toStdString();
-        throw(FontObfuscationError(msg));
+        return IdpfKeyFromIdentifier(identifier);
     }
+
+    std::string msg = algorithm.toStdString() + ": " + identifier.toStdString();
+    throw(FontObfuscationError(msg));
 }
 
 
+void FontObfuscation::ObfuscateBlock(char *data,
+                                     qint64 size,
+                                     qint64 pos,
+                                     const QString &algorithm,
+                                     const QByteArray &key)
+{
+    int key_size = key.size();
+    if (key_size == 0) {
+        return;
+    }
+
+    qint64 num_bytes = algorithm == ADOBE_FONT_ALGO_ID ? ADOBE_METHOD_NUM_BYTES : IDPF_METHOD_NUM_BYTES;
+
+    for (qint64 i = pos; (i < num_bytes) && (i < pos + size); ++i) {
+        data[ i - pos ] = data[ i - pos ] ^ key[ (int)(i % key_size) ];
+    }
+}
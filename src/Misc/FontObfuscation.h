@@ -23,6 +23,8 @@
 #ifndef FONTOBFUSCATION_H
 #define FONTOBFUSCATION_H
 
+#include <QtCore/QByteArray>
+
 class QString;
 
 namespace FontObfuscation
@@ -30,6 +32,19 @@ namespace FontObfuscation
 void ObfuscateFile(const QString &filepath,
                    const QString &algorithm,
                    const QString &identifier);
+
+// Returns the key the algorithm derives from the identifier,
+// throws FontObfuscationError if none can be derived
+QByteArray KeyFromIdentifier(const QString &algorithm,
+                             const QString &identifier);
+
+// Obfuscates a block of font data that starts at offset pos in the
+// font file; calling it on consecutive blocks obfuscates a stream
+void ObfuscateBlock(char *data,
+                    qint64 size,
+                    qint64 pos,
+                    const QString &algorithm,
+                    const QByteArray &key);
 }
 
 #endif // FONTOBFUSCATION_H
@@ -0,0 +1,231 @@
+/************************************************************************
+**
+**  Copyright (C) 2020 Kevin B. Hendricks, Stratford, Ontario, Canada
+**
+**  This file is part of Sigil.
+**
+**  Sigil is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  Sigil is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with Sigil.  If not, see <http://www.gnu.org/licenses/>.
+**
+*************************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+#include <mutex>
+
+#include "gumbo.h"
+#include "Misc/GumboArena.h"
+
+namespace
+{
+
+// Size of the chunks the arena grabs from the heap. Blocks larger
+// than half of this get a chunk of their own.
+const size_t ARENA_CHUNK_SIZE = 256 * 1024;
+
+// Keeps the memory after the header aligned like malloc does.
+struct BlockHeader {
+    size_t size;
+    size_t in_arena;
+};
+
+const size_t BLOCK_ALIGNMENT = sizeof(BlockHeader);
+
+inline size_t AlignedSize(size_t size)
+{
+    return (size + BLOCK_ALIGNMENT - 1) & ~(BLOCK_ALIGNMENT - 1);
+}
+
+inline BlockHeader *HeaderOf(void *ptr)
+{
+    return static_cast<BlockHeader *>(ptr) - 1;
+}
+
+// The arena used for allocations made by gumbo on this thread.
+thread_local GumboArena *t_CurrentArena = NULL;
+
+std::once_flag g_InstallFlag;
+
+}
+
+
+GumboArena::GumboArena()
+    :
+    m_Current(NULL),
+    m_Remaining(0),
+    m_LastBlock(NULL)
+{
+}
+
+
+GumboArena::~GumboArena()
+{
+    for (size_t i = 0; i < m_Chunks.size(); i++) {
+        free(m_Chunks.at(i));
+    }
+}
+
+
+void GumboArena::InstallAllocator()
+{
+    std::call_once(g_InstallFlag, []() {
+        gumbo_memory_set_allocator(GumboAllocator);
+        gumbo_memory_set_free(GumboFree);
+    });
+}
+
+
+GumboArena::Scope::Scope(GumboArena &arena)
+    :
+    m_Previous(t_CurrentArena)
+{
+    t_CurrentArena = &arena;
+}
+
+
+GumboArena::Scope::~Scope()
+{
+    t_CurrentArena = m_Previous;
+}
+
+
+void *GumboArena::Allocate(size_t size)
+{
+    size_t needed = sizeof(BlockHeader) + AlignedSize(size);
+    char *block;
+
+    if (needed > ARENA_CHUNK_SIZE / 2) {
+        // Large blocks get a chunk of their own so the current chunk is kept.
+        block = static_cast<char *>(malloc(needed));
+
+        if (!block) {
+            return NULL;
+        }
+
+        m_Chunks.push_back(block);
+    } else {
+        if (needed > m_Remaining) {
+            m_Current = static_cast<char *>(malloc(ARENA_CHUNK_SIZE));
+
+            if (!m_Current) {
+                m_Remaining = 0;
+                return NULL;
+            }
+
+            m_Chunks.push_back(m_Current);
+            m_Remaining = ARENA_CHUNK_SIZE;
+        }
+
+        block = m_Current;
+        m_Current += needed;
+        m_Remaining -= needed;
+        m_LastBlock = block;
+    }
+
+    BlockHeader *header = reinterpret_cast<BlockHeader *>(block);
+    header->size = size;
+    header->in_arena = 1;
+    return header + 1;
+}
+
+
+bool GumboArena::Resize(void *ptr, size_t size)
+{
+    // Only the last block handed out from the current chunk can grow.
+    char *block = reinterpret_cast<char *>(HeaderOf(ptr));
+
+    if (block != m_LastBlock) {
+        return false;
+    }
+
+    BlockHeader *header = HeaderOf(ptr);
+    size_t old_size = AlignedSize(header->size);
+    size_t new_size = AlignedSize(size);
+
+    if (new_size > old_size && new_size - old_size > m_Remaining) {
+        return false;
+    }
+
+    m_Current = m_Current - old_size + new_size;
+    m_Remaining = m_Remaining + old_size - new_size;
+    header->size = size;
+    return true;
+}
+
+
+void *GumboArena::NewBlock(size_t size)
+{
+    if (t_CurrentArena) {
+        return t_CurrentArena->Allocate(size);
+    }
+
+    BlockHeader *header = static_cast<BlockHeader *>(malloc(sizeof(BlockHeader) + size));
+
+    if (!header) {
+        return NULL;
+    }
+
+    header->size = size;
+    header->in_arena = 0;
+    return header + 1;
+}
+
+
+void *GumboArena::GumboAllocator(void *ptr, size_t size)
+{
+    if (!ptr) {
+        return NewBlock(size);
+    }
+
+    BlockHeader *header = HeaderOf(ptr);
+
+    if (!header->in_arena) {
+        BlockHeader *resized = static_cast<BlockHeader *>(realloc(header, sizeof(BlockHeader) + size));
+
+        if (!resized) {
+            return NULL;
+        }
+
+        resized->size = size;
+        return resized + 1;
+    }
+
+    if (t_CurrentArena && t_CurrentArena->Resize(ptr, size)) {
+        return ptr;
+    }
+
+    // Arena blocks are never moved or freed on their own. The
+    // old block stays allocated until the arena goes away.
+    void *moved = NewBlock(size);
+
+    if (moved) {
+        memcpy(moved, ptr, header->size < size ? header->size : size);
+    }
+
+    return moved;
+}
+
+
+void GumboArena::GumboFree(void *ptr)
+{
+    if (!ptr) {
+        return;
+    }
+
+    BlockHeader *header = HeaderOf(ptr);
+
+    // Arena blocks are released with the arena.
+    if (!header->in_arena) {
+        free(header);
+    }
+}
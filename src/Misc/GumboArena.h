@@ -0,0 +1,87 @@
+/************************************************************************
+**
+**  Copyright (C) 2020 Kevin B. Hendricks, Stratford, Ontario, Canada
+**
+**  This file is part of Sigil.
+**
+**  Sigil is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  Sigil is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with Sigil.  If not, see <http://www.gnu.org/licenses/>.
+**
+*************************************************************************/
+
+#pragma once
+#ifndef GUMBOARENA_H
+#define GUMBOARENA_H
+
+#include <stddef.h>
+#include <vector>
+
+/**
+ * Bump allocator for the memory of one gumbo parse.
+ *
+ * Gumbo only has a single process wide allocator so GumboArena installs
+ * one allocator for the whole process that hands out memory from the arena
+ * made current on the calling thread with GumboArena::Scope, and from the
+ * heap otherwise. Every block carries a small header telling the two apart
+ * so gumbo_free on an arena block does nothing and the arena memory is
+ * released all at once when the arena is destroyed.
+ *
+ * Concurrent parses on different threads each use their own arena and
+ * never touch the global heap for the tree.
+ */
+class GumboArena
+{
+public:
+    GumboArena();
+    ~GumboArena();
+
+    /**
+     * Install the arena aware allocator into gumbo. Must be called before
+     * anything is allocated by gumbo. Safe to call more than once.
+     */
+    static void InstallAllocator();
+
+    /**
+     * Makes an arena the one used for gumbo allocations on the current
+     * thread for the lifetime of the scope.
+     */
+    class Scope
+    {
+    public:
+        Scope(GumboArena &arena);
+        ~Scope();
+
+    private:
+        GumboArena *m_Previous;
+    };
+
+private:
+    // Not copyable, gumbo trees point into the arena.
+    GumboArena(const GumboArena &);
+    GumboArena &operator=(const GumboArena &);
+
+    void *Allocate(size_t size);
+    bool Resize(void *block, size_t size);
+
+    static void *GumboAllocator(void *ptr, size_t size);
+    static void GumboFree(void *ptr);
+    static void *NewBlock(size_t size);
+
+    std::vector<char *> m_Chunks;
+    char *m_Current;
+    size_t m_Remaining;
+    // The most recent block. It can grow in place.
+    char *m_LastBlock;
+};
+
+#endif // GUMBOARENA_H
@@ -122,8 +122,10 @@ GumboInterface::GumboInterface(const QString &source, const QString &version)
           m_currentdir(""),
           m_newbody(""),
           m_version(version),
-	  m_newbookpath("")
+	  m_newbookpath(""),
+          m_arena(std::make_shared<GumboArena>())
 {
+    GumboArena::InstallAllocator();
 }
 
 
@@ -137,14 +139,18 @@ GumboInterface::GumboInterface(const QString &source, const QString &version, co
           m_currentdir(""),
           m_newbody(""),
           m_version(version),
-	  m_newbookpath("")
+	  m_newbookpath(""),
+          m_arena(std::make_shared<GumboArena>())
 {
+    GumboArena::InstallAllocator();
 }
 
 
 GumboInterface::~GumboInterface()
 {
     if (m_output != NULL) {
+        // frees only what was added to the tree after parsing, the
+        // parsed tree itself goes away with m_arena
         gumbo_destroy_output(m_output);
         m_output = NULL;
         m_utf8src = "";
@@ -177,9 +183,9 @@ void GumboInterface::parse()
 	myoptions.max_tree_depth = 400;
         myoptions.max_errors = 50;
 
-        // GumboInterface::m_mutex.lock();
+        // the tree is built in our own arena so it can be released all at once
+        GumboArena::Scope arena_scope(*m_arena);
         m_output = gumbo_parse_with_options(&myoptions, m_utf8src.data(), m_utf8src.length());
-        // GumboInterface::m_mutex.unlock();
     }
 }
 
@@ -536,6 +542,7 @@ QList<GumboWellFormedError> GumboInterface::error_check()
             }
             line_offset--;
         }
+        GumboArena::Scope arena_scope(*m_arena);
         m_output = gumbo_parse_with_options(&myoptions, m_utf8src.data(), m_utf8src.length());
     }
     // qDebug() << QString::fromStdString(m_utf8src);
@@ -578,6 +585,7 @@ QList<GumboWellFormedError> GumboInterface::fragment_error_check()
     if (!m_source.isEmpty() && (m_output == NULL)) {
 
         m_utf8src = m_source.toStdString();
+        GumboArena::Scope arena_scope(*m_arena);
         m_output = gumbo_parse_fragment(&myoptions, m_utf8src.data(), m_utf8src.length(),
 					GUMBO_TAG_BODY, GUMBO_NAMESPACE_HTML);
     }
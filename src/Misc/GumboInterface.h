@@ -24,11 +24,13 @@
 #define GUMBO_INTERFACE
 
 #include <stdlib.h>
+#include <memory>
 #include <string>
 #include <unordered_set>
 
 #include "gumbo.h"
 #include "gumbo_edit.h"
+#include "Misc/GumboArena.h"
 
 #include <QString>
 #include <QList>
@@ -162,6 +164,9 @@ private:
     std::string                     m_newbody;
     QString                         m_version;
     QString                         m_newbookpath;
+    // holds the memory of the output tree, released after gumbo_destroy_output
+    // (shared so the copy initialization used by callers still compiles)
+    std::shared_ptr<GumboArena>     m_arena;
     
 };
 
@@ -28,6 +28,7 @@
 #include "Misc/SettingsStore.h"
 #include "Misc/SpellCheck.h"
 #include "Misc/HTMLSpellCheck.h"
+#include "PCRE/PCRECache.h"
 #include "sigil_constants.h"
 #include "sigil_exception.h"
 
@@ -51,7 +52,10 @@ QList<HTMLSpellCheck::MisspelledWord> HTMLSpellCheck::GetMisspelledWords(const Q
     int word_start = 0;
     SettingsStore ss;
     bool use_nums = ss.spellCheckNumbers();
-    QRegularExpression search(search_regex);
+    QSharedPointer<SPCRE> search;
+    if (!search_regex.isEmpty()) {
+        search = PCRECache::instance()->getObject(search_regex);
+    }
     QList<HTMLSpellCheck::MisspelledWord> misspellings;
     // Make sure text has beginning/end boundary markers for easier parsing
     QString text = QChar(' ') + orig_text + QChar(' ');
@@ -86,14 +90,7 @@ QList<HTMLSpellCheck::MisspelledWord> HTMLSpellCheck::GetMisspelledWords(const Q
 
                     if (!word.isEmpty() && word_start > start_offset && word_start <= end_offset) {
                         if (include_all_words || !sc->spell(word)) {
-                            int cap_start = -1;
-
-                            if (!search_regex.isEmpty()) {
-                                QRegularExpressionMatch mo = search.match(word);
-                                cap_start = mo.capturedStart();
-                            }
-
-                            if (search_regex.isEmpty() || cap_start != -1) {
+                            if (search_regex.isEmpty() || search->hasMatch(word)) {
                                 struct MisspelledWord misspelled_word;
                                 misspelled_word.text = word;
                                 // Make sure we account for the extra boundary added at the beginning
@@ -21,37 +21,123 @@
 
 #include <signal.h>
 
+#include <functional>
+
 #include <QtCore/QtCore>
+#include <QtConcurrent/QtConcurrent>
 #include <QtWidgets/QApplication>
 #include <QtWidgets/QProgressDialog>
 
 #include "BookManipulation/CleanSource.h"
 #include "Misc/SearchOperations.h"
 #include "Misc/SettingsStore.h"
+#include "Misc/TagSpanIndex.h"
 #include "Misc/Utility.h"
 #include "PCRE/PCRECache.h"
+#include "PCRE/PCREReplaceAllBuilder.h"
 #include "Misc/HTMLSpellCheck.h"
 #include "ResourceObjects/HTMLResource.h"
 #include "ResourceObjects/TextResource.h"
 #include "ViewEditors/Searchable.h"
 #include "sigil_constants.h"
 
+template <typename T>
+void SearchOperations::WaitForFuture(QFuture<T> &future, QProgressDialog &progress)
+{
+    QFutureWatcher<T> watcher;
+    QEventLoop loop;
+    QObject::connect(&watcher, SIGNAL(progressValueChanged(int)), &progress, SLOT(setValue(int)));
+    QObject::connect(&watcher, SIGNAL(finished()), &loop, SLOT(quit()));
+    QObject::connect(&progress, SIGNAL(canceled()), &watcher, SLOT(cancel()));
+    watcher.setFuture(future);
+
+    // Keep the progress dialog responsive while the worker threads run.
+    if (!watcher.isFinished()) {
+        loop.exec();
+    }
+
+    watcher.waitForFinished();
+}
+
+
+QList<SearchOperations::SourceText> SearchOperations::GetSourceTexts(const QList<Resource *> &resources)
+{
+    QList<SourceText> sources;
+    foreach(Resource * resource, resources) {
+        SourceText source;
+        source.resource = resource;
+        TextResource *text_resource = qobject_cast<TextResource *>(resource);
+
+        if (text_resource) {
+            QReadLocker locker(&text_resource->GetLock());
+            source.text = text_resource->GetText();
+        }
+
+        sources.append(source);
+    }
+    return sources;
+}
+
+
+bool SearchOperations::SetChangedText(const SourceText &source, const QString &new_text)
+{
+    TextResource *text_resource = qobject_cast<TextResource *>(source.resource);
+
+    if (!text_resource) {
+        return false;
+    }
+
+    QWriteLocker locker(&text_resource->GetLock());
+
+    if (text_resource->GetText() != source.text) {
+        return false;
+    }
+
+    text_resource->SetText(new_text);
+    return true;
+}
+
+
 int SearchOperations::CountInFiles(const QString &search_regex,
                                    QList<Resource *> resources,
                                    SearchType search_type,
                                    bool check_spelling,
 								   bool exclude_html_tag)
 {
-    QProgressDialog progress(QObject::tr("Counting occurrences.."), 0, 0, resources.count(), Utility::GetMainWindow());
+    QProgressDialog progress(QObject::tr("Counting occurrences.."), QObject::tr("Cancel"), 0, resources.count(), Utility::GetMainWindow());
+    progress.setWindowModality(Qt::WindowModal);
     progress.setMinimumDuration(PROGRESS_BAR_MINIMUM_DURATION);
-    int progress_value = 0;
-    progress.setValue(progress_value);
-    // Count sequentially in order to see if occassional crashes are due to threading
+    progress.setValue(0);
+    QList<SourceText> sources = GetSourceTexts(resources);
+
+    // The spellchecker is not safe to share between threads.
+    if (check_spelling) {
+        int count = 0;
+        int progress_value = 0;
+        foreach(const SourceText &source, sources) {
+            if (progress.wasCanceled()) {
+                break;
+            }
+            progress.setValue(progress_value++);
+            qApp->processEvents();
+            count += CountInFile(search_regex, source, search_type, check_spelling, exclude_html_tag);
+        }
+        return count;
+    }
+
+    QFuture<int> future = QtConcurrent::mapped(sources,
+                                               std::bind(CountInFile,
+                                                         search_regex,
+                                                         std::placeholders::_1,
+                                                         search_type,
+                                                         check_spelling,
+                                                         exclude_html_tag));
+    WaitForFuture(future, progress);
+
+    // Files that were not counted before a cancel have no result.
     int count = 0;
-    foreach(Resource * resource, resources) {
-        progress.setValue(progress_value++);
-        qApp->processEvents();
-		count += CountInFile(search_regex, resource, search_type, check_spelling, exclude_html_tag);
+    foreach(int file_count, future.results()) {
+        count += file_count;
     }
     return count;
 }
@@ -63,38 +149,213 @@ int SearchOperations::ReplaceInAllFIles(const QString &search_regex,
                                         SearchType search_type,
 										bool exclude_html_tag)
 {
-    QProgressDialog progress(QObject::tr("Replacing search term..."), 0, 0, resources.count(), Utility::GetMainWindow());
+    QProgressDialog progress(QObject::tr("Replacing search term..."), QObject::tr("Cancel"), 0, resources.count(), Utility::GetMainWindow());
+    progress.setWindowModality(Qt::WindowModal);
     progress.setMinimumDuration(PROGRESS_BAR_MINIMUM_DURATION);
-    int progress_value = 0;
-    progress.setValue(progress_value);
-    // Replace sequentially in order to see if occassional crashes are due to threading
+    progress.setValue(0);
+    QList<SourceText> sources = GetSourceTexts(resources);
+
+    // The new text for each file is created in parallel but only stored
+    // back in the resources once all threads are done. SetText has to be
+    // called from the GUI thread for open tabs to be updated safely.
+    QFuture<ReplaceResult> future = QtConcurrent::mapped(sources,
+                                                         std::bind(ReplaceInFile,
+                                                                   search_regex,
+                                                                   replacement,
+                                                                   std::placeholders::_1,
+                                                                   search_type,
+                                                                   exclude_html_tag));
+    WaitForFuture(future, progress);
+
+    // Files that were not processed before a cancel are left unchanged.
     int count = 0;
-    foreach(Resource * resource, resources) {
-        progress.setValue(progress_value++);
-        qApp->processEvents();
-        count += ReplaceInFile(search_regex, replacement, resource, search_type, exclude_html_tag);
+    foreach(const ReplaceResult &result, future.results()) {
+        if (result.count > 0 && SetChangedText(result.source, result.new_text)) {
+            count += result.count;
+        }
     }
     return count;
 }
 
 
+QVector<int> SearchOperations::CountInFiles(const QList<SearchStep> &steps,
+                                           QList<Resource *> resources,
+                                           SearchType search_type,
+                                           bool exclude_html_tag)
+{
+    QProgressDialog progress(QObject::tr("Counting occurrences.."), QObject::tr("Cancel"), 0, resources.count(), Utility::GetMainWindow());
+    progress.setWindowModality(Qt::WindowModal);
+    progress.setMinimumDuration(PROGRESS_BAR_MINIMUM_DURATION);
+    progress.setValue(0);
+    QList<CompiledStep> compiled_steps = CompileSteps(steps);
+
+    QFuture<GroupResult> future = QtConcurrent::mapped(GetSourceTexts(resources),
+                                                       std::bind(CountGroupInFile,
+                                                                 compiled_steps,
+                                                                 std::placeholders::_1,
+                                                                 search_type,
+                                                                 exclude_html_tag));
+    WaitForFuture(future, progress);
+
+    QVector<int> counts(steps.count(), 0);
+    foreach(const GroupResult &result, future.results()) {
+        for (int i = 0; i < result.counts.count(); i++) {
+            counts[i] += result.counts.at(i);
+        }
+    }
+    MarkInvalidSteps(compiled_steps, counts);
+    return counts;
+}
+
+
+QVector<int> SearchOperations::ReplaceInAllFIles(const QList<SearchStep> &steps,
+                                                QList<Resource *> resources,
+                                                SearchType search_type,
+                                                bool exclude_html_tag)
+{
+    QProgressDialog progress(QObject::tr("Replacing search term..."), QObject::tr("Cancel"), 0, resources.count(), Utility::GetMainWindow());
+    progress.setWindowModality(Qt::WindowModal);
+    progress.setMinimumDuration(PROGRESS_BAR_MINIMUM_DURATION);
+    progress.setValue(0);
+    QList<CompiledStep> compiled_steps = CompileSteps(steps);
+
+    QFuture<GroupResult> future = QtConcurrent::mapped(GetSourceTexts(resources),
+                                                       std::bind(ReplaceGroupInFile,
+                                                                 compiled_steps,
+                                                                 std::placeholders::_1,
+                                                                 search_type,
+                                                                 exclude_html_tag));
+    WaitForFuture(future, progress);
+
+    // As with a single search the texts are only stored back on the GUI
+    // thread. Files that were not processed before a cancel are left unchanged.
+    QVector<int> counts(steps.count(), 0);
+    foreach(const GroupResult &result, future.results()) {
+        int file_count = 0;
+
+        for (int i = 0; i < result.counts.count(); i++) {
+            file_count += result.counts.at(i);
+        }
+
+        if (file_count == 0 || !SetChangedText(result.source, result.new_text)) {
+            continue;
+        }
+
+        for (int i = 0; i < result.counts.count(); i++) {
+            counts[i] += result.counts.at(i);
+        }
+    }
+    MarkInvalidSteps(compiled_steps, counts);
+    return counts;
+}
+
+
+QList<SearchOperations::CompiledStep> SearchOperations::CompileSteps(const QList<SearchStep> &steps)
+{
+    // Compiled on the calling thread so the workers share the same
+    // objects instead of each looking them up in the cache.
+    QList<CompiledStep> compiled;
+    foreach(const SearchStep &step, steps) {
+        CompiledStep compiled_step;
+        compiled_step.spcre = PCRECache::instance()->getObject(step.search_regex);
+        compiled_step.replacement = step.replacement;
+        compiled.append(compiled_step);
+    }
+    return compiled;
+}
+
+
+void SearchOperations::MarkInvalidSteps(const QList<CompiledStep> &steps, QVector<int> &counts)
+{
+    for (int i = 0; i < steps.count() && i < counts.count(); i++) {
+        if (!steps.at(i).spcre->isValid()) {
+            counts[i] = -1;
+        }
+    }
+}
+
+
+SearchOperations::GroupResult SearchOperations::CountGroupInFile(const QList<CompiledStep> &steps,
+                                                                 const SourceText &source,
+                                                                 SearchType search_type,
+                                                                 bool exclude_html_tag)
+{
+    GroupResult result;
+    result.source = source;
+    result.counts.fill(0, steps.count());
+
+    if (!qobject_cast<HTMLResource *>(source.resource) || search_type != SearchOperations::CodeViewSearch) {
+        return result;
+    }
+
+    // Counting does not change the text so the tag index is shared by all steps.
+    const QString &text = source.text;
+    QScopedPointer<TagSpanIndex> tag_index(exclude_html_tag ? new TagSpanIndex(text) : NULL);
+
+    for (int i = 0; i < steps.count(); i++) {
+        if (steps.at(i).spcre->isValid()) {
+            result.counts[i] = CountMatches(text, *steps.at(i).spcre, tag_index.data());
+        }
+    }
+
+    return result;
+}
+
+
+SearchOperations::GroupResult SearchOperations::ReplaceGroupInFile(const QList<CompiledStep> &steps,
+                                                                   const SourceText &source,
+                                                                   SearchType search_type,
+                                                                   bool exclude_html_tag)
+{
+    GroupResult result;
+    result.source = source;
+    result.counts.fill(0, steps.count());
+
+    if (!qobject_cast<HTMLResource *>(source.resource) || search_type != SearchOperations::CodeViewSearch) {
+        return result;
+    }
+
+    // Each step works on the output of the previous one, the same as
+    // running the searches one after the other.
+    QString text = source.text;
+    QScopedPointer<TagSpanIndex> tag_index;
+
+    for (int i = 0; i < steps.count(); i++) {
+        if (!steps.at(i).spcre->isValid()) {
+            continue;
+        }
+
+        // The index only needs to be rebuilt when a step changed the text.
+        if (exclude_html_tag && !tag_index) {
+            tag_index.reset(new TagSpanIndex(text));
+        }
+
+        QString new_text;
+        std::tie(new_text, result.counts[i]) = PerformGlobalReplace(text, *steps.at(i).spcre, steps.at(i).replacement, tag_index.data());
+
+        if (result.counts.at(i) > 0) {
+            text = new_text;
+            tag_index.reset();
+        }
+    }
+
+    result.new_text = text;
+    return result;
+}
+
+
 int SearchOperations::CountInFile(const QString &search_regex,
-                                  Resource *resource,
+                                  const SourceText &source,
                                   SearchType search_type,
                                   bool check_spelling,
 								  bool exclude_html_tag)
 {
-    QReadLocker locker(&resource->GetLock());
-    HTMLResource *html_resource = qobject_cast<HTMLResource *>(resource);
-
-    if (html_resource) {
-        return CountInHTMLFile(search_regex, html_resource, search_type, check_spelling, exclude_html_tag);
+    if (qobject_cast<HTMLResource *>(source.resource)) {
+        return CountInHTMLFile(search_regex, source.text, search_type, check_spelling, exclude_html_tag);
     }
 
-    TextResource *text_resource = qobject_cast<TextResource *>(resource);
-
-    if (text_resource) {
-        return CountInTextFile(search_regex, text_resource);
+    if (qobject_cast<TextResource *>(source.resource)) {
+        return CountInTextFile(search_regex, source.text);
     }
 
     // We should never get here.
@@ -102,42 +363,20 @@ int SearchOperations::CountInFile(const QString &search_regex,
 }
 
 int SearchOperations::CountInHTMLFile(const QString &search_regex,
-                                      HTMLResource *html_resource,
+                                      const QString &text,
                                       SearchType search_type,
                                       bool check_spelling,
 									  bool exclude_html_tag)
 {
     if (search_type == SearchOperations::CodeViewSearch) {
-        const QString &text = html_resource->GetText();
-
         if (check_spelling) {
             return HTMLSpellCheck::CountMisspelledWords(text, 0, text.count(), search_regex);
         } else {
+			QSharedPointer<SPCRE> spcre = PCRECache::instance()->getObject(search_regex);
 			if (!exclude_html_tag)
-				return PCRECache::instance()->getObject(search_regex)->getEveryMatchInfo(text).count();
-			int start = 0, end = text.length(), count = 0;
-			QList<SPCRE::MatchInfo> match_info = PCRECache::instance()->getObject(search_regex)->getEveryMatchInfo(text);
-			SPCRE *spcreTagStart = PCRECache::instance()->getObject(QString("<"));
-			SPCRE *spcreTagEnd = PCRECache::instance()->getObject(QString(">"));
-
-			SPCRE::MatchInfo match_info_tag_start_before, match_info_tag_end_before;
-			SPCRE::MatchInfo match_info_tag_start_after, match_info_tag_end_after;
-
-			for (int i = match_info.count() - 1; i >= 0; i--) {
-
-				match_info_tag_start_after = spcreTagStart->getFirstMatchInfo(Utility::Substring(match_info[i].offset.second, end, text));
-				match_info_tag_end_after = spcreTagEnd->getFirstMatchInfo(Utility::Substring(match_info[i].offset.second, end, text));
-				match_info_tag_start_before = spcreTagStart->getLastMatchInfo(Utility::Substring(start, match_info[i].offset.first, text));
-				match_info_tag_end_before = spcreTagEnd->getLastMatchInfo(Utility::Substring(start, match_info[i].offset.first, text));
-
-				if ((match_info_tag_start_before.offset.first != -1 && (match_info_tag_end_before.offset.first == -1 || (match_info_tag_end_before.offset.first != -1 && match_info_tag_end_before.offset.second < match_info_tag_start_before.offset.second))) &&
-					(match_info_tag_end_after.offset.first != -1 && (match_info_tag_start_after.offset.first == -1 || (match_info_tag_start_after.offset.first != -1 && match_info_tag_end_after.offset.second < match_info_tag_start_after.offset.second)))) {
-					continue;
-				}
-				count++;
-			}
-			return count;
-
+				return CountMatches(text, *spcre, NULL);
+			TagSpanIndex tag_index(text);
+			return CountMatches(text, *spcre, &tag_index);
 		}
 	}
 
@@ -145,65 +384,78 @@ int SearchOperations::CountInHTMLFile(const QString &search_regex,
     return 0;
 }
 
-int SearchOperations::CountInTextFile(const QString &search_regex, TextResource *text_resource)
+int SearchOperations::CountInTextFile(const QString &search_regex, const QString &text)
 {
     // TODO
     return 0;
 }
 
 
-int SearchOperations::ReplaceInFile(const QString &search_regex,
+int SearchOperations::CountMatches(const QString &text, SPCRE &spcre, const TagSpanIndex *tag_index)
+{
+    if (!tag_index) {
+        return spcre.getMatchCount(text);
+    }
+
+    int count = 0;
+    SPCRE::MatchIterator it(spcre, text);
+
+    while (it.next()) {
+        if (!tag_index->IsInsideTag(it.start(), it.end())) {
+            count++;
+        }
+    }
+
+    return count;
+}
+
+
+SearchOperations::ReplaceResult SearchOperations::ReplaceInFile(const QString &search_regex,
                                     const QString &replacement,
-                                    Resource *resource,
+                                    const SourceText &source,
                                     SearchType search_type,
 									bool exclude_html_tag)
 {
-    QWriteLocker locker(&resource->GetLock());
-    HTMLResource *html_resource = qobject_cast<HTMLResource *>(resource);
+    ReplaceResult result;
+    result.source = source;
+    result.count = 0;
 
-    if (html_resource) {
-        return ReplaceHTMLInFile(search_regex, replacement, html_resource, search_type, exclude_html_tag);
+    if (qobject_cast<HTMLResource *>(source.resource)) {
+        std::tie(result.new_text, result.count) = ReplaceHTMLInFile(search_regex, replacement, source.text, search_type, exclude_html_tag);
+        return result;
     }
 
-    TextResource *text_resource = qobject_cast<TextResource *>(resource);
-
-    if (text_resource) {
-        return ReplaceTextInFile(search_regex, replacement, text_resource);
+    if (qobject_cast<TextResource *>(source.resource)) {
+        std::tie(result.new_text, result.count) = ReplaceTextInFile(search_regex, replacement, source.text);
+        return result;
     }
 
     // We should never get here.
-    return 0;
+    return result;
 }
 
 
-int SearchOperations::ReplaceHTMLInFile(const QString &search_regex,
+std::tuple<QString, int> SearchOperations::ReplaceHTMLInFile(const QString &search_regex,
                                         const QString &replacement,
-                                        HTMLResource *html_resource,
+                                        const QString &text,
                                         SearchType search_type,
 										bool exclude_html_tag)
 {
-    SettingsStore ss;
-
     if (search_type == SearchOperations::CodeViewSearch) {
-        int count;
-        QString new_text;
-        QString text = html_resource->GetText();
-        std::tie(new_text, count) = PerformGlobalReplace(text, search_regex, replacement, exclude_html_tag);
-        html_resource->SetText(new_text);
-        return count;
+        return PerformGlobalReplace(text, search_regex, replacement, exclude_html_tag);
     }
 
     //TODO: BookViewSearch
-    return 0;
+    return std::make_tuple(QString(), 0);
 }
 
 
-int SearchOperations::ReplaceTextInFile(const QString &search_regex,
+std::tuple<QString, int> SearchOperations::ReplaceTextInFile(const QString &search_regex,
                                         const QString &replacement,
-                                        TextResource *text_resource)
+                                        const QString &text)
 {
     // TODO
-    return 0;
+    return std::make_tuple(QString(), 0);
 }
 
 
@@ -212,52 +464,37 @@ std::tuple<QString, int> SearchOperations::PerformGlobalReplace(const QString &t
         const QString &replacement,
 		bool exclude_html_tag)
 {
-	QString new_text = text;
-	int count = 0;
-	SPCRE *spcre = PCRECache::instance()->getObject(search_regex);
-	QList<SPCRE::MatchInfo> match_info = spcre->getEveryMatchInfo(text);
-	int start = 0, end = text.length();
-	SPCRE *spcreTagStart = PCRECache::instance()->getObject(QString("<"));
-	SPCRE *spcreTagEnd = PCRECache::instance()->getObject(QString(">"));
-
-	SPCRE::MatchInfo match_info_tag_start_before, match_info_tag_end_before;
-	SPCRE::MatchInfo match_info_tag_start_after, match_info_tag_end_after;
+	QSharedPointer<SPCRE> spcre = PCRECache::instance()->getObject(search_regex);
 
 	if (exclude_html_tag)
 	{
-		for (int i = match_info.count() - 1; i >= 0; i--) {
-			match_info_tag_start_after = spcreTagStart->getFirstMatchInfo(Utility::Substring(match_info[i].offset.second, end, text));
-			match_info_tag_end_after = spcreTagEnd->getFirstMatchInfo(Utility::Substring(match_info[i].offset.second, end, text));
-			match_info_tag_start_before = spcreTagStart->getLastMatchInfo(Utility::Substring(start, match_info[i].offset.first, text));
-			match_info_tag_end_before = spcreTagEnd->getLastMatchInfo(Utility::Substring(start, match_info[i].offset.first, text));
-
-			if ((match_info_tag_start_before.offset.first != -1 && (match_info_tag_end_before.offset.first == -1 || (match_info_tag_end_before.offset.first != -1 && match_info_tag_end_before.offset.second < match_info_tag_start_before.offset.second))) &&
-				(match_info_tag_end_after.offset.first != -1 && (match_info_tag_start_after.offset.first == -1 || (match_info_tag_start_after.offset.first != -1 && match_info_tag_end_after.offset.second < match_info_tag_start_after.offset.second)))) {
-				continue;
-			}
-
-			QString match_segement = Utility::Substring(match_info.at(i).offset.first, match_info.at(i).offset.second, new_text);
-			QString replacement_text;
-
-			if (spcre->replaceText(match_segement, match_info.at(i).capture_groups_offsets, replacement, replacement_text)) {
-				new_text.replace(match_info.at(i).offset.first, match_info.at(i).offset.second - match_info.at(i).offset.first, replacement_text);
-				count++;
-			}
-		}
-	}
-	else
-	{
-		for (int i = match_info.count() - 1; i >= 0; i--) {
-			QString match_segement = Utility::Substring(match_info.at(i).offset.first, match_info.at(i).offset.second, new_text);
-			QString replacement_text;
-
-			if (spcre->replaceText(match_segement, match_info.at(i).capture_groups_offsets, replacement, replacement_text)) {
-				new_text.replace(match_info.at(i).offset.first, match_info.at(i).offset.second - match_info.at(i).offset.first, replacement_text);
-				count++;
-			}
-		}
+		TagSpanIndex tag_index(text);
+		return PerformGlobalReplace(text, *spcre, replacement, &tag_index);
 	}
 
+	return PerformGlobalReplace(text, *spcre, replacement, NULL);
+}
+
+
+std::tuple<QString, int> SearchOperations::PerformGlobalReplace(const QString &text,
+        SPCRE &spcre,
+        const QString &replacement,
+        const TagSpanIndex *tag_index)
+{
+    QString new_text;
+    QList<SPCRE::MatchInfo> match_info;
+    SPCRE::MatchIterator it(spcre, text);
+
+    while (it.next()) {
+        if (tag_index && tag_index->IsInsideTag(it.start(), it.end())) {
+            continue;
+        }
+
+        match_info.append(it.matchInfo());
+    }
+
+    PCREReplaceAllBuilder builder(spcre, replacement);
+    int count = builder.Build(text, match_info, new_text);
     return std::make_tuple(new_text, count);
 }
 
@@ -266,29 +503,23 @@ std::tuple<QString, int> SearchOperations::PerformHTMLSpellCheckReplace(const QS
         const QString &search_regex,
         const QString &replacement)
 {
-    QString new_text = text;
-    int count = 0;
-    int offset = 0;
-    SPCRE *spcre = PCRECache::instance()->getObject(search_regex);
+    QString new_text;
+    QSharedPointer<SPCRE> spcre = PCRECache::instance()->getObject(search_regex);
     QList<HTMLSpellCheck::MisspelledWord> check_spelling = HTMLSpellCheck::GetMisspelledWords(text, 0, text.count(), search_regex);
+    QList<SPCRE::MatchInfo> match_info;
     foreach(HTMLSpellCheck::MisspelledWord misspelled_word, check_spelling) {
-        SPCRE::MatchInfo match_info = spcre->getFirstMatchInfo(misspelled_word.text);
-
-        if (match_info.offset.first != -1) {
-            QString replacement_text;
-
-            if (spcre->replaceText(Utility::Substring(match_info.offset.first, match_info.offset.second, misspelled_word.text), match_info.capture_groups_offsets, replacement, replacement_text)) {
-                new_text.replace(offset + misspelled_word.offset + match_info.offset.first, match_info.offset.second - match_info.offset.first, replacement_text);
-                offset += replacement_text.length() - (match_info.offset.second - match_info.offset.first);
-                count++;
-            }
+        SPCRE::MatchInfo word_match = spcre->getFirstMatchInfo(misspelled_word.text);
+
+        if (word_match.offset.first != -1) {
+            // Capture groups are relative to the match so only the match
+            // itself needs to be moved to its location in the text.
+            word_match.offset.first += misspelled_word.offset;
+            word_match.offset.second += misspelled_word.offset;
+            match_info.append(word_match);
         }
     }
-    return std::make_tuple(new_text, count);
-}
-
 
-void SearchOperations::Accumulate(int &first, const int &second)
-{
-    first += second;
+    PCREReplaceAllBuilder builder(*spcre, replacement);
+    int count = builder.Build(text, match_info, new_text);
+    return std::make_tuple(new_text, count);
 }
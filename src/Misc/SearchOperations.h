@@ -23,9 +23,17 @@
 #ifndef SEARCHOPERATIONS_H
 #define SEARCHOPERATIONS_H
 
+#include <QtCore/QFuture>
+#include <QtCore/QSharedPointer>
+#include <QtCore/QString>
+#include <QtCore/QVector>
+
 class Resource;
+class SPCRE;
 class TextResource;
 class HTMLResource;
+class TagSpanIndex;
+class QProgressDialog;
 
 class SearchOperations
 {
@@ -37,6 +45,14 @@ public:
         CodeViewSearch
     };
 
+    /**
+     * One search of a saved search group.
+     */
+    struct SearchStep {
+        QString search_regex;
+        QString replacement;
+    };
+
     /**
      * Returns the number of matching occurrences.
      *
@@ -56,51 +72,175 @@ public:
                                  SearchType search_type,
 								 bool exclude_html_tag = false);
 
+    /**
+     * Counts the matches of every step of a search group.
+     *
+     * Each file is read once and all steps are counted against it.
+     * Files are processed in parallel.
+     *
+     * @return The number of matches of each step over all the files,
+     *         -1 for a step whose pattern is not a valid regex.
+     */
+    static QVector<int> CountInFiles(const QList<SearchStep> &steps,
+                                     QList<Resource *> resources,
+                                     SearchType search_type,
+                                     bool exclude_html_tag = false);
+
+    /**
+     * Runs the replacements of a search group.
+     *
+     * Every pattern is compiled once. For each file the text is read
+     * once, each step is applied in order to the result of the previous
+     * step and the final text is written back once. Files are processed
+     * in parallel.
+     *
+     * @return The number of replacements made by each step over all the files,
+     *         -1 for a step whose pattern is not a valid regex.
+     */
+    static QVector<int> ReplaceInAllFIles(const QList<SearchStep> &steps,
+                                          QList<Resource *> resources,
+                                          SearchType search_type,
+                                          bool exclude_html_tag = false);
+
 private:
 
+    /**
+     * The text of a resource as it was when the search started. The
+     * text is read on the GUI thread, the worker threads only ever
+     * see these copies and never the resources themselves.
+     */
+    struct SourceText {
+        Resource *resource;
+        QString text;
+    };
+
+    /**
+     * A search group step with its pattern compiled.
+     */
+    struct CompiledStep {
+        QSharedPointer<SPCRE> spcre;
+        QString replacement;
+    };
+
+    /**
+     * The result of running a search group on one file. The new text
+     * is only set when replacing.
+     */
+    struct GroupResult {
+        SourceText source;
+        QString new_text;
+        QVector<int> counts;
+    };
+
+    /**
+     * The replaced text of one file. Created by the worker threads
+     * and stored back in the resource on the GUI thread.
+     */
+    struct ReplaceResult {
+        SourceText source;
+        QString new_text;
+        int count;
+    };
+
+    /**
+     * Wait for the worker threads while keeping the progress dialog
+     * updated. Canceling the dialog cancels the remaining work.
+     */
+    template <typename T>
+    static void WaitForFuture(QFuture<T> &future, QProgressDialog &progress);
+
+    /**
+     * Reads the texts of the resources. Must be called on the GUI
+     * thread since an open tab holds the text in its QTextDocument.
+     */
+    static QList<SourceText> GetSourceTexts(const QList<Resource *> &resources);
+
+    /**
+     * Stores the new text of a resource unless the resource was
+     * changed since its text was read, so edits made while the
+     * workers ran are never overwritten.
+     *
+     * @return If the new text was stored.
+     */
+    static bool SetChangedText(const SourceText &source, const QString &new_text);
+
     static int CountInFile(const QString &search_regex,
-                           Resource *resource,
+                           const SourceText &source,
                            SearchType search_type,
                            bool check_spelling,
 						   bool exclude_html_tag);
 
 
     static int CountInHTMLFile(const QString &search_regex,
-                               HTMLResource *html_resource,
+                               const QString &text,
                                SearchType search_type,
                                bool check_spelling,
 							   bool exclude_html_tag);
 
 
     static int CountInTextFile(const QString &search_regex,
-                               TextResource *text_resource);
+                               const QString &text);
 
-    static int ReplaceInFile(const QString &search_regex,
+    static QList<CompiledStep> CompileSteps(const QList<SearchStep> &steps);
+
+    /**
+     * Marks the steps whose pattern did not compile with a count of -1.
+     */
+    static void MarkInvalidSteps(const QList<CompiledStep> &steps, QVector<int> &counts);
+
+    static GroupResult CountGroupInFile(const QList<CompiledStep> &steps,
+                                        const SourceText &source,
+                                        SearchType search_type,
+                                        bool exclude_html_tag);
+
+    static GroupResult ReplaceGroupInFile(const QList<CompiledStep> &steps,
+                                          const SourceText &source,
+                                          SearchType search_type,
+                                          bool exclude_html_tag);
+
+    /**
+     * Count the matches of a pattern in a text.
+     *
+     * @param tag_index When set matches inside of tags are not counted.
+     */
+    static int CountMatches(const QString &text,
+                            SPCRE &spcre,
+                            const TagSpanIndex *tag_index);
+
+    static ReplaceResult ReplaceInFile(const QString &search_regex,
                              const QString &replacement,
-                             Resource *resource,
+                             const SourceText &source,
                              SearchType search_type,
 							 bool exclude_html_tag = false);
 
-    static int ReplaceHTMLInFile(const QString &search_regex,
+    static std::tuple<QString, int> ReplaceHTMLInFile(const QString &search_regex,
                                  const QString &replacement,
-                                 HTMLResource *html_resource,
+                                 const QString &text,
                                  SearchType search_type,
 								 bool exclude_html_tag);
 
-    static int ReplaceTextInFile(const QString &search_regex,
+    static std::tuple<QString, int> ReplaceTextInFile(const QString &search_regex,
                                  const QString &replacement,
-                                 TextResource *text_resource);
+                                 const QString &text);
 
     static std::tuple<QString, int> PerformGlobalReplace(const QString &text,
             const QString &search_regex,
             const QString &replacement,
 			bool exclude_html_tag);
 
+    /**
+     * Replace every match of a compiled pattern in a text.
+     *
+     * @param tag_index When set matches inside of tags are not replaced.
+     */
+    static std::tuple<QString, int> PerformGlobalReplace(const QString &text,
+            SPCRE &spcre,
+            const QString &replacement,
+            const TagSpanIndex *tag_index);
+
     static std::tuple<QString, int> PerformHTMLSpellCheckReplace(const QString &text,
             const QString &search_regex,
             const QString &replacement);
-
-    static void Accumulate(int &first, const int &second);
 };
 
 #endif // SEARCHOPERATIONS_H
@@ -46,6 +46,8 @@ static QString KEY_RENAME_TEMPLATE = SETTINGS_GROUP + "/" + "rename_template";
 static QString KEY_DICTIONARY_NAME = SETTINGS_GROUP + "/" + "dictionary_name";
 static QString KEY_SPELL_CHECK = SETTINGS_GROUP + "/" + "spell_check";
 static QString KEY_SPELL_CHECK_NUMBERS = SETTINGS_GROUP + "/" + "spell_check_numbers";
+static QString KEY_REGEX_JIT = SETTINGS_GROUP + "/" + "regex_jit";
+static QString KEY_EXPORT_COMPRESSION = SETTINGS_GROUP + "/" + "export_compression";
 static QString KEY_DEFAULT_USER_DICTIONARY = SETTINGS_GROUP + "/" + "user_dictionary_name";
 static QString KEY_ENABLED_USER_DICTIONARIES = SETTINGS_GROUP + "/" + "enabled_user_dictionaries";
 static QString KEY_PLUGIN_USER_MAP = SETTINGS_GROUP + "/" + "plugin_user_map";
@@ -208,6 +210,18 @@ bool SettingsStore::spellCheckNumbers()
     return static_cast<bool>(value(KEY_SPELL_CHECK_NUMBERS, false).toBool());
 }
 
+bool SettingsStore::regexJIT()
+{
+    clearSettingsGroup();
+    return static_cast<bool>(value(KEY_REGEX_JIT, true).toBool());
+}
+
+QString SettingsStore::exportCompression()
+{
+    clearSettingsGroup();
+    return value(KEY_EXPORT_COMPRESSION, "balanced").toString();
+}
+
 QString SettingsStore::defaultUserDictionary()
 {
     clearSettingsGroup();
@@ -500,6 +514,18 @@ void SettingsStore::setSpellCheckNumbers(bool enabled)
     setValue(KEY_SPELL_CHECK_NUMBERS, enabled);
 }
 
+void SettingsStore::setRegexJIT(bool enabled)
+{
+    clearSettingsGroup();
+    setValue(KEY_REGEX_JIT, enabled);
+}
+
+void SettingsStore::setExportCompression(const QString &profile)
+{
+    clearSettingsGroup();
+    setValue(KEY_EXPORT_COMPRESSION, profile);
+}
+
 void SettingsStore::setDefaultUserDictionary(const QString &name)
 {
     clearSettingsGroup();
@@ -120,6 +120,20 @@ public:
 
     bool spellCheckNumbers();
 
+    /**
+     * Whether regular expressions are JIT compiled for searching
+     *
+     * @return if JIT compilation is enabled
+     */
+    bool regexJIT();
+
+    /**
+     * How hard epubs are compressed on save
+     *
+     * @return "fast", "balanced" or "smallest"
+     */
+    QString exportCompression();
+
     /**
      * The name of the file containing user words
      *
@@ -310,6 +324,20 @@ public slots:
     
     void setSpellCheckNumbers(bool enabled);
 
+    /**
+     * Set whether regular expressions are JIT compiled
+     *
+     * @param enabled Use the JIT when available.
+     */
+    void setRegexJIT(bool enabled);
+
+    /**
+     * Set how hard epubs are compressed on save
+     *
+     * @param profile "fast", "balanced" or "smallest".
+     */
+    void setExportCompression(const QString &profile);
+
     /**
      * Set the name of the dictionary file to store user words.
      *
@@ -0,0 +1,114 @@
+/************************************************************************
+**
+**  Copyright (C) 2020 Kevin B. Hendricks, Stratford, Ontario, Canada
+**
+**  This file is part of Sigil.
+**
+**  Sigil is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  Sigil is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with Sigil.  If not, see <http://www.gnu.org/licenses/>.
+**
+*************************************************************************/
+
+#include <algorithm>
+
+#include "Misc/TagSpanIndex.h"
+
+namespace
+{
+
+// Find the last offset in the sorted list that is in [range_start, limit).
+// Returns -1 if there is none.
+int LastBefore(const QVector<int> &offsets, int limit, int range_start)
+{
+    QVector<int>::const_iterator it = std::lower_bound(offsets.constBegin(), offsets.constEnd(), limit);
+
+    if (it == offsets.constBegin()) {
+        return -1;
+    }
+
+    --it;
+    return *it >= range_start ? *it : -1;
+}
+
+// Find the first offset in the sorted list that is in [limit, range_end).
+// Returns -1 if there is none.
+int FirstFrom(const QVector<int> &offsets, int limit, int range_end)
+{
+    QVector<int>::const_iterator it = std::lower_bound(offsets.constBegin(), offsets.constEnd(), limit);
+
+    if (it == offsets.constEnd()) {
+        return -1;
+    }
+
+    return *it < range_end ? *it : -1;
+}
+
+}
+
+TagSpanIndex::TagSpanIndex()
+    :
+    m_TextLength(0)
+{
+}
+
+TagSpanIndex::TagSpanIndex(const QString &text)
+    :
+    m_TextLength(text.length())
+{
+    const QChar *data = text.constData();
+
+    for (int i = 0; i < m_TextLength; ++i) {
+        ushort c = data[i].unicode();
+
+        if (c == '<') {
+            m_TagStarts.append(i);
+        } else if (c == '>') {
+            m_TagEnds.append(i);
+        }
+    }
+}
+
+bool TagSpanIndex::IsInsideTag(int match_start, int match_end, int range_start, int range_end) const
+{
+    if (range_end < 0 || range_end > m_TextLength) {
+        range_end = m_TextLength;
+    }
+
+    // The closest delimiter before the match must be an opening '<'.
+    int tag_start_before = LastBefore(m_TagStarts, match_start, range_start);
+
+    if (tag_start_before == -1) {
+        return false;
+    }
+
+    int tag_end_before = LastBefore(m_TagEnds, match_start, range_start);
+
+    if (tag_end_before > tag_start_before) {
+        return false;
+    }
+
+    // And the closest delimiter after the match must be a closing '>'.
+    int tag_end_after = FirstFrom(m_TagEnds, match_end, range_end);
+
+    if (tag_end_after == -1) {
+        return false;
+    }
+
+    int tag_start_after = FirstFrom(m_TagStarts, match_end, range_end);
+    return tag_start_after == -1 || tag_end_after < tag_start_after;
+}
+
+int TagSpanIndex::TextLength() const
+{
+    return m_TextLength;
+}
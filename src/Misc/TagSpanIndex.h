@@ -0,0 +1,78 @@
+/************************************************************************
+**
+**  Copyright (C) 2020 Kevin B. Hendricks, Stratford, Ontario, Canada
+**
+**  This file is part of Sigil.
+**
+**  Sigil is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  Sigil is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with Sigil.  If not, see <http://www.gnu.org/licenses/>.
+**
+*************************************************************************/
+
+#pragma once
+#ifndef TAGSPANINDEX_H
+#define TAGSPANINDEX_H
+
+#include <QtCore/QString>
+#include <QtCore/QVector>
+
+/**
+ * Index of the tag delimiters in a piece of (x)html text.
+ *
+ * Used by the "exclude html tags" search option to decide if a match
+ * lies inside of a <...> tag. The text is scanned once when the index
+ * is built and each query is then two binary searches instead of
+ * rescanning the text before and after the match.
+ */
+class TagSpanIndex
+{
+public:
+    TagSpanIndex();
+
+    /**
+     * Build the index for the given text.
+     *
+     * @param text The text to index.
+     */
+    TagSpanIndex(const QString &text);
+
+    /**
+     * Is the match located inside of a tag.
+     *
+     * A match is inside of a tag when the closest tag delimiter before it
+     * is a '<' and the closest tag delimiter after it is a '>'. Only the
+     * delimiters within [range_start, range_end) are considered.
+     *
+     * @param match_start Offset in the indexed text where the match starts.
+     * @param match_end Offset in the indexed text where the match ends.
+     * @param range_start Start of the searched range.
+     * @param range_end End of the searched range, -1 for the end of the text.
+     *
+     * @return True if the match should be excluded.
+     */
+    bool IsInsideTag(int match_start, int match_end, int range_start = 0, int range_end = -1) const;
+
+    /**
+     * The length of the text this index was built for.
+     */
+    int TextLength() const;
+
+private:
+    // Offsets of every '<' in the text in ascending order.
+    QVector<int> m_TagStarts;
+    // Offsets of every '>' in the text in ascending order.
+    QVector<int> m_TagEnds;
+    int m_TextLength;
+};
+
+#endif // TAGSPANINDEX_H
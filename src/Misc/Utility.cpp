@@ -27,6 +27,12 @@
 #include "unzip.h"
 #ifdef _WIN32
 #include "iowin32.h"
+#else
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+#ifdef __APPLE__
+#include <copyfile.h>
 #endif
 
 #include <stdio.h>
@@ -483,6 +489,89 @@ bool Utility::RenameFile(const QString &oldfilepath, const QString &newfilepath)
 }
 
 
+bool Utility::LinkOrCopyFile(const QString &fullinpath, const QString &fulloutpath)
+{
+    if (!QFileInfo(fullinpath).exists() || QFileInfo::exists(fulloutpath)) {
+        return false;
+    }
+
+    int ret = -1;
+#if defined(Q_OS_WIN32)
+    if (CreateHardLinkW(Utility::QStringToStdWString(fulloutpath).data(), Utility::QStringToStdWString(fullinpath).data(), NULL)) {
+        ret = 0;
+    }
+#else
+    ret = link(fullinpath.toUtf8().data(), fulloutpath.toUtf8().data());
+#endif
+
+    if (ret == 0) {
+        return true;
+    }
+
+    // different volumes or no hard link support
+    return QFile::copy(fullinpath, fulloutpath);
+}
+
+
+bool Utility::ReplaceFile(const QString &newfilepath, const QString &targetfilepath)
+{
+    if (!QFileInfo(newfilepath).exists()) {
+        return false;
+    }
+
+    // Replace the file a symbolic link points to and keep the link.
+    // A dangling link is left to the caller.
+    QString target = targetfilepath;
+    QFileInfo target_info(targetfilepath);
+    if (target_info.isSymLink()) {
+        target = target_info.canonicalFilePath();
+        if (target.isEmpty()) {
+            return false;
+        }
+    }
+
+    if (QFileInfo(target).exists()) {
+        // Renaming over a file with other hard links would split it off
+        // from them, so the caller has to overwrite it in place instead.
+#if defined(Q_OS_WIN32)
+        HANDLE handle = CreateFileW(Utility::QStringToStdWString(target).data(), 0,
+                                    FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                                    NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+        if (handle != INVALID_HANDLE_VALUE) {
+            BY_HANDLE_FILE_INFORMATION file_info;
+            bool linked = GetFileInformationByHandle(handle, &file_info) && file_info.nNumberOfLinks > 1;
+            CloseHandle(handle);
+            if (linked) {
+                return false;
+            }
+        }
+#else
+        struct stat st;
+        if (stat(target.toUtf8().data(), &st) == 0 && st.st_nlink > 1) {
+            return false;
+        }
+#endif
+        QFile::setPermissions(newfilepath, QFile::permissions(target));
+#ifdef Q_OS_MAC
+        // labels and other Finder metadata live in extended attributes
+        copyfile(target.toUtf8().data(), newfilepath.toUtf8().data(), NULL, COPYFILE_XATTR);
+#endif
+    }
+
+    int ret = -1;
+#if defined(Q_OS_WIN32)
+    if (MoveFileExW(Utility::QStringToStdWString(newfilepath).data(),
+                    Utility::QStringToStdWString(target).data(),
+                    MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH)) {
+        ret = 0;
+    }
+#else
+    ret = rename(newfilepath.toUtf8().data(), target.toUtf8().data());
+#endif
+    return ret == 0;
+}
+
+
 QString Utility::GetTemporaryFileNameWithExtension(const QString &extension)
 {
     SettingsStore ss;
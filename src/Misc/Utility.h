@@ -108,6 +108,18 @@ public:
 
     static bool RenameFile(const QString &oldfilepath, const QString &newfilepath);
 
+    // Gives a file a second name, as a hard link where the file system
+    // allows it so nothing is written, or else as a copy
+    static bool LinkOrCopyFile(const QString &fullinpath, const QString &fulloutpath);
+
+    // Puts a finished file in place of the target in one atomic rename so
+    // the target is never seen half written; an existing target passes its
+    // permissions (and extended attributes on OS X) on to the new file.
+    // A symbolic link is followed and kept. Returns false without renaming
+    // for a dangling link or a target with other hard links, which must be
+    // overwritten in place to stay linked
+    static bool ReplaceFile(const QString &newfilepath, const QString &targetfilepath);
+
     // Returns path to a random filename with the specified extension in
     // the systems TEMP directory. The caller has responsibility for
     // creating a file at this location and removing it afterwards.
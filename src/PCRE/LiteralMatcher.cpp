@@ -0,0 +1,244 @@
+/************************************************************************
+**
+**  Copyright (C) 2020 Kevin B. Hendricks, Stratford, Ontario, Canada
+**
+**  This file is part of Sigil.
+**
+**  Sigil is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  Sigil is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with Sigil.  If not, see <http://www.gnu.org/licenses/>.
+**
+*************************************************************************/
+
+#include <cstring>
+
+#include "PCRE/LiteralMatcher.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define LITERALMATCHER_SSE2
+#include <emmintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+namespace
+{
+
+// Characters that have a special meaning in a pattern when not escaped.
+const QString REGEX_METACHARACTERS = "\\^$.|?*+()[]{}";
+
+inline ushort FoldCase(ushort c)
+{
+    if (c < 128) {
+        return (c >= 'A' && c <= 'Z') ? c + ('a' - 'A') : c;
+    }
+
+    return static_cast<ushort>(QChar::toCaseFolded(static_cast<uint>(c)));
+}
+
+inline bool IsAsciiAlnum(ushort c)
+{
+    return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+}
+
+#ifdef LITERALMATCHER_SSE2
+inline int LowestBit(unsigned int mask)
+{
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward(&index, mask);
+    return static_cast<int>(index);
+#else
+    return __builtin_ctz(mask);
+#endif
+}
+#endif
+
+}
+
+bool LiteralMatcher::ParsePattern(const QString &pattern, QString &literal, bool &caseless)
+{
+    caseless = false;
+    literal.clear();
+    int length = pattern.length();
+    int i = 0;
+
+    // Leading option settings such as (?i)(?s)(?U).
+    while (pattern.midRef(i, 2) == "(?") {
+        int j = i + 2;
+
+        while (j < length && QString("ismU").contains(pattern.at(j))) {
+            if (pattern.at(j) == QChar('i')) {
+                caseless = true;
+            }
+            j++;
+        }
+
+        if (j == i + 2 || j >= length || pattern.at(j) != QChar(')')) {
+            return false;
+        }
+
+        i = j + 1;
+    }
+
+    literal.reserve(length - i);
+
+    for (; i < length; i++) {
+        QChar c = pattern.at(i);
+
+        if (c == QChar('\\')) {
+            // A backslash followed by anything other than an ASCII letter
+            // or digit is that character literally.
+            if (i + 1 >= length || IsAsciiAlnum(pattern.at(i + 1).unicode())) {
+                return false;
+            }
+
+            literal.append(pattern.at(++i));
+        } else if (REGEX_METACHARACTERS.contains(c)) {
+            return false;
+        } else {
+            literal.append(c);
+        }
+    }
+
+    if (literal.isEmpty()) {
+        return false;
+    }
+
+    // Only simple case folding of the BMP is done so leave caseless
+    // searches for characters outside of it to PCRE.
+    if (caseless) {
+        foreach(QChar c, literal) {
+            if (c.isSurrogate()) {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+LiteralMatcher::LiteralMatcher(const QString &literal, bool caseless)
+    :
+    m_caseless(caseless)
+{
+    int length = literal.length();
+    m_pattern.resize(length);
+
+    for (int i = 0; i < length; i++) {
+        ushort c = literal.at(i).unicode();
+        m_pattern[i] = caseless ? FoldCase(c) : c;
+    }
+
+    // Code units sharing a low byte share a slot. The smallest shift
+    // wins which keeps the search correct.
+    for (int i = 0; i < 256; i++) {
+        m_shift[i] = length;
+    }
+
+    for (int i = 0; i < length - 1; i++) {
+        m_shift[m_pattern.at(i) & 0xFF] = length - 1 - i;
+    }
+}
+
+int LiteralMatcher::Length() const
+{
+    return m_pattern.size();
+}
+
+int LiteralMatcher::IndexIn(const ushort *text, int length, int from) const
+{
+    if (from < 0 || m_pattern.isEmpty() || from > length - m_pattern.size()) {
+        return -1;
+    }
+
+    if (m_caseless) {
+        return IndexInCaseless(text, length, from);
+    }
+
+    return IndexInSensitive(text, length, from);
+}
+
+int LiteralMatcher::IndexInSensitive(const ushort *text, int length, int from) const
+{
+    const ushort *pattern = m_pattern.constData();
+    const int m = m_pattern.size();
+    const int last = length - m;
+    int i = from;
+#ifdef LITERALMATCHER_SSE2
+    // Check 8 candidate positions at once. A position is only verified
+    // when both the first and the last character of the pattern match.
+    const __m128i first_char = _mm_set1_epi16(static_cast<short>(pattern[0]));
+    const __m128i last_char = _mm_set1_epi16(static_cast<short>(pattern[m - 1]));
+
+    for (; i + 8 <= last + 1; i += 8) {
+        __m128i block_first = _mm_loadu_si128(reinterpret_cast<const __m128i *>(text + i));
+        __m128i block_last = _mm_loadu_si128(reinterpret_cast<const __m128i *>(text + i + m - 1));
+        __m128i found = _mm_and_si128(_mm_cmpeq_epi16(block_first, first_char),
+                                      _mm_cmpeq_epi16(block_last, last_char));
+        // Two mask bits per code unit.
+        unsigned int mask = static_cast<unsigned int>(_mm_movemask_epi8(found));
+
+        while (mask != 0) {
+            int bit = LowestBit(mask);
+            int position = i + bit / 2;
+
+            if (m <= 2 || memcmp(text + position + 1, pattern + 1, (m - 2) * sizeof(ushort)) == 0) {
+                return position;
+            }
+
+            mask &= ~(3u << bit);
+        }
+    }
+#endif
+    // Horspool for what is left.
+    while (i <= last) {
+        ushort c = text[i + m - 1];
+
+        if (c == pattern[m - 1] && memcmp(text + i, pattern, (m - 1) * sizeof(ushort)) == 0) {
+            return i;
+        }
+
+        i += m_shift[c & 0xFF];
+    }
+
+    return -1;
+}
+
+int LiteralMatcher::IndexInCaseless(const ushort *text, int length, int from) const
+{
+    const ushort *pattern = m_pattern.constData();
+    const int m = m_pattern.size();
+    const int last = length - m;
+    int i = from;
+
+    while (i <= last) {
+        ushort c = FoldCase(text[i + m - 1]);
+
+        if (c == pattern[m - 1]) {
+            int j = 0;
+
+            while (j < m - 1 && FoldCase(text[i + j]) == pattern[j]) {
+                j++;
+            }
+
+            if (j == m - 1) {
+                return i;
+            }
+        }
+
+        i += m_shift[c & 0xFF];
+    }
+
+    return -1;
+}
@@ -0,0 +1,94 @@
+/************************************************************************
+**
+**  Copyright (C) 2020 Kevin B. Hendricks, Stratford, Ontario, Canada
+**
+**  This file is part of Sigil.
+**
+**  Sigil is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  Sigil is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with Sigil.  If not, see <http://www.gnu.org/licenses/>.
+**
+*************************************************************************/
+
+#pragma once
+#ifndef LITERALMATCHER_H
+#define LITERALMATCHER_H
+
+#include <QtCore/QString>
+#include <QtCore/QVector>
+
+/**
+ * Fast substring search used by SPCRE for patterns without any
+ * regular expression syntax.
+ *
+ * Most searches are plain text (Normal and Case Sensitive modes escape
+ * the text into a regex). Running those through PCRE is much slower
+ * than a dedicated substring search. Candidates are found by scanning
+ * for the first and last character of the pattern 8 UTF-16 code units
+ * at a time when SSE2 is available and then verified. Everything else,
+ * and case insensitive searches, use Boyer-Moore-Horspool.
+ */
+class LiteralMatcher
+{
+public:
+    /**
+     * Check if a pattern only matches literal text.
+     *
+     * The pattern may start with inline option settings that do not
+     * change how literal text matches ((?i), (?s), (?m), (?U)) followed by
+     * text where every metacharacter is escaped with a backslash. This is
+     * what QRegularExpression::escape creates.
+     *
+     * @param pattern The regular expression.
+     * @param[out] literal The text the pattern matches.
+     * @param[out] caseless If the match is case insensitive.
+     *
+     * @return True if the pattern is a literal.
+     */
+    static bool ParsePattern(const QString &pattern, QString &literal, bool &caseless);
+
+    /**
+     * Constructor.
+     *
+     * @param literal The text to search for. Must not be empty.
+     * @param caseless Match using simple Unicode case folding.
+     */
+    LiteralMatcher(const QString &literal, bool caseless);
+
+    /**
+     * Find the first occurrence of the literal.
+     *
+     * @param text The text to search.
+     * @param length The length of the text in UTF-16 code units.
+     * @param from Where to start searching.
+     *
+     * @return The offset of the match or -1 if there is no match.
+     */
+    int IndexIn(const ushort *text, int length, int from) const;
+
+    /**
+     * The length of every match.
+     */
+    int Length() const;
+
+private:
+    int IndexInSensitive(const ushort *text, int length, int from) const;
+    int IndexInCaseless(const ushort *text, int length, int from) const;
+
+    // The literal. Case folded for caseless searches.
+    QVector<ushort> m_pattern;
+    bool m_caseless;
+    // Horspool shift table indexed by the low byte of a code unit.
+    int m_shift[256];
+};
+
+#endif // LITERALMATCHER_H
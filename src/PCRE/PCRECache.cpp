@@ -20,12 +20,16 @@
 **
 *************************************************************************/
 
+#include "Misc/SettingsStore.h"
 #include "PCRE/PCRECache.h"
 
 PCRECache *PCRECache::m_instance = 0;
 
 PCRECache *PCRECache::instance()
 {
+    static QMutex instance_mutex;
+    QMutexLocker locker(&instance_mutex);
+
     if (m_instance == 0) {
         m_instance = new PCRECache();
     }
@@ -36,24 +40,69 @@ PCRECache *PCRECache::instance()
 PCRECache::PCRECache()
 {
   // defaults to maxCacheCost of 100
+  SettingsStore ss;
+  m_useJIT = ss.regexJIT();
 }
 
 bool PCRECache::insert(const QString &key, SPCRE *object)
 {
+    return insert(key, QSharedPointer<SPCRE>(object));
+}
+
+bool PCRECache::insert(const QString &key, QSharedPointer<SPCRE> object)
+{
+    QMutexLocker locker(&m_mutex);
     // raise cost of each entry to 5 to reduce memory footprint
-    return m_cache.insert(key, object, 5);
+    return m_cache.insert(key, new QSharedPointer<SPCRE>(object), 5);
 }
 
-SPCRE *PCRECache::getObject(const QString &key)
+QSharedPointer<SPCRE> PCRECache::getObject(const QString &key)
 {
+    bool use_jit;
+    {
+        QMutexLocker locker(&m_mutex);
+        QSharedPointer<SPCRE> *cached = m_cache.object(key);
+
+        if (cached) {
+            return *cached;
+        }
+
+        use_jit = m_useJIT;
+    }
+
     // Create a new SPCRE if it doesn't already exist.
     // The key is the pattern for initializing the SPCRE.
-    if (!m_cache.contains(key)) {
-        SPCRE *spcre = new SPCRE(key);
-        // raise cost of each entry to 5 to reduce memory footprint
-        m_cache.insert(key, spcre, 5);
-        return spcre;
+    // Compiling is done without holding the lock so threads
+    // compiling different patterns don't wait on each other.
+    QSharedPointer<SPCRE> spcre(new SPCRE(key, use_jit));
+
+    QMutexLocker locker(&m_mutex);
+    QSharedPointer<SPCRE> *cached = m_cache.object(key);
+
+    // Another thread created it while we were compiling.
+    if (cached) {
+        return *cached;
     }
 
-    return m_cache.object(key);
+    // raise cost of each entry to 5 to reduce memory footprint
+    m_cache.insert(key, new QSharedPointer<SPCRE>(spcre), 5);
+    return spcre;
+}
+
+void PCRECache::setUseJIT(bool use_jit)
+{
+    QMutexLocker locker(&m_mutex);
+
+    if (m_useJIT == use_jit) {
+        return;
+    }
+
+    m_useJIT = use_jit;
+    m_cache.clear();
+}
+
+bool PCRECache::useJIT()
+{
+    QMutexLocker locker(&m_mutex);
+    return m_useJIT;
 }
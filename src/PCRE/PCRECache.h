@@ -26,6 +26,8 @@
 #define PCRECACHE_H
 
 #include <QtCore/QCache>
+#include <QtCore/QMutex>
+#include <QtCore/QSharedPointer>
 #include <QtCore/QString>
 
 #include "PCRE/SPCRE.h"
@@ -34,6 +36,10 @@
  * Singleton. A cache of SPCRE regular expression objects.
  *
  * The SPCRE's are cached to improve performance.
+ *
+ * The cache can be used from multiple threads at once. Objects are
+ * handed out as shared pointers so an SPCRE evicted from the cache
+ * stays alive until every thread using it is done with it.
  */
 class PCRECache
 {
@@ -54,6 +60,7 @@ public:
      * @return True if the object was successfully inserted.
      */
     bool insert(const QString &key, SPCRE *object);
+    bool insert(const QString &key, QSharedPointer<SPCRE> object);
     /**
      * Retrieve the SPCRE object from the cache.
      *
@@ -62,7 +69,18 @@ public:
      *
      * @param key The key associated with the SPCRE.
      */
-    SPCRE *getObject(const QString &key);
+    QSharedPointer<SPCRE> getObject(const QString &key);
+
+    /**
+     * Set whether newly created SPCRE's are JIT compiled.
+     *
+     * Changing the mode clears the cache so every pattern
+     * is recompiled using the new mode.
+     *
+     * @param use_jit True to JIT compile patterns.
+     */
+    void setUseJIT(bool use_jit);
+    bool useJIT();
 
 private:
     /**
@@ -71,7 +89,11 @@ private:
     PCRECache();
 
     // The cache that we store the SPCRE's.
-    QCache<QString, SPCRE> m_cache;
+    QCache<QString, QSharedPointer<SPCRE>> m_cache;
+    // Guards the cache and settings.
+    QMutex m_mutex;
+    // Whether patterns are studied with the JIT compiler.
+    bool m_useJIT;
     // The single instance of the cache.
     static PCRECache *m_instance;
 };
@@ -0,0 +1,109 @@
+/************************************************************************
+**
+**  Copyright (C) 2020 Kevin B. Hendricks, Stratford, Ontario, Canada
+**
+**  This file is part of Sigil.
+**
+**  Sigil is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  Sigil is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with Sigil.  If not, see <http://www.gnu.org/licenses/>.
+**
+*************************************************************************/
+
+#include <QtCore/QVector>
+
+#include "PCRE/PCREReplaceAllBuilder.h"
+#include "Misc/Utility.h"
+
+PCREReplaceAllBuilder::PCREReplaceAllBuilder(SPCRE &sre, const QString &replacement_pattern)
+    :
+    m_sre(sre),
+    m_replacementPattern(replacement_pattern)
+{
+}
+
+int PCREReplaceAllBuilder::Build(const QString &text,
+                                 const QList<SPCRE::MatchInfo> &matches,
+                                 QString &out,
+                                 QList<ChangeRange> *changes)
+{
+    // Create the replacement text for every match first so we know the
+    // size of the final text before we start copying.
+    QVector<QString> replacements(matches.count());
+    QVector<bool> replaced(matches.count(), false);
+    int new_length = text.length();
+    int count = 0;
+
+    for (int i = 0; i < matches.count(); i++) {
+        const SPCRE::MatchInfo &match = matches.at(i);
+        QString match_segment = Utility::Substring(match.offset.first, match.offset.second, text);
+
+        if (m_sre.replaceText(match_segment, match.capture_groups_offsets, m_replacementPattern, replacements[i])) {
+            replaced[i] = true;
+            new_length += replacements.at(i).length() - (match.offset.second - match.offset.first);
+            count++;
+        }
+    }
+
+    if (count == 0) {
+        out = text;
+        return 0;
+    }
+
+    QString new_text;
+    new_text.reserve(new_length);
+    const QChar *data = text.constData();
+    int last_end = 0;
+
+    for (int i = 0; i < matches.count(); i++) {
+        if (!replaced.at(i)) {
+            continue;
+        }
+
+        const SPCRE::MatchInfo &match = matches.at(i);
+        // Copy the unchanged text up to this match then the replacement.
+        new_text.append(data + last_end, match.offset.first - last_end);
+
+        if (changes) {
+            ChangeRange change;
+            change.old_start = match.offset.first;
+            change.old_length = match.offset.second - match.offset.first;
+            change.new_start = new_text.length();
+            change.new_length = replacements.at(i).length();
+            changes->append(change);
+        }
+
+        new_text.append(replacements.at(i));
+        last_end = match.offset.second;
+    }
+
+    new_text.append(data + last_end, text.length() - last_end);
+    out = new_text;
+    return count;
+}
+
+int PCREReplaceAllBuilder::MapPosition(const QList<ChangeRange> &changes, int position)
+{
+    int delta = 0;
+    foreach(const ChangeRange &change, changes) {
+        if (position < change.old_start) {
+            break;
+        }
+
+        if (position < change.old_start + change.old_length) {
+            return change.new_start;
+        }
+
+        delta += change.new_length - change.old_length;
+    }
+    return position + delta;
+}
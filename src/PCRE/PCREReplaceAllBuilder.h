@@ -0,0 +1,99 @@
+/************************************************************************
+**
+**  Copyright (C) 2020 Kevin B. Hendricks, Stratford, Ontario, Canada
+**
+**  This file is part of Sigil.
+**
+**  Sigil is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  Sigil is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with Sigil.  If not, see <http://www.gnu.org/licenses/>.
+**
+*************************************************************************/
+
+#pragma once
+#ifndef PCREREPLACEALLBUILDER_H
+#define PCREREPLACEALLBUILDER_H
+
+#include <QtCore/QList>
+#include <QtCore/QString>
+
+#include "PCRE/SPCRE.h"
+
+/**
+ * Apply a replacement pattern to a list of matches in one pass.
+ *
+ * Replacing matches one at a time with QString::replace moves the tail
+ * of the text for every match which is quadratic for large files. This
+ * builder instead creates the replacement text for every match, sizes
+ * the output once and copies the unchanged segments and the replacements
+ * into it from front to back.
+ */
+class PCREReplaceAllBuilder
+{
+public:
+    /**
+     * A region of the text that was replaced.
+     */
+    struct ChangeRange {
+        // Where the replaced text started in the original text.
+        int old_start;
+        int old_length;
+        // Where the replacement starts in the new text.
+        int new_start;
+        int new_length;
+    };
+
+    /**
+     * Constructor.
+     *
+     * @param sre The SPCRE the matches were created with.
+     * @param replacement_pattern The replacement pattern. Can be text or text
+     * and control characters.
+     */
+    PCREReplaceAllBuilder(SPCRE &sre, const QString &replacement_pattern);
+
+    /**
+     * Replace the matches in the text.
+     *
+     * @param text The text the matches were found in.
+     * @param matches The matches to replace. They must be in ascending
+     * order and must not overlap.
+     * @param[out] out The text with all replacements made.
+     * @param[out] changes If not NULL receives the replaced regions in
+     * ascending order.
+     *
+     * @return The number of replacements made.
+     */
+    int Build(const QString &text,
+              const QList<SPCRE::MatchInfo> &matches,
+              QString &out,
+              QList<ChangeRange> *changes = NULL);
+
+    /**
+     * Translate a position in the original text to the new text.
+     *
+     * Positions inside of a replaced region are moved to the start
+     * of its replacement.
+     *
+     * @param changes The changes returned by Build.
+     * @param position The position in the original text.
+     *
+     * @return The position in the new text.
+     */
+    static int MapPosition(const QList<ChangeRange> &changes, int position);
+
+private:
+    SPCRE &m_sre;
+    QString m_replacementPattern;
+};
+
+#endif // PCREREPLACEALLBUILDER_H
@@ -19,19 +19,61 @@
 **
 *************************************************************************/
 
+#include <QtCore/QThreadStorage>
+
 #include "PCRE/SPCRE.h"
+#include "PCRE/LiteralMatcher.h"
 #include "PCRE/PCREReplaceTextBuilder.h"
 #include "sigil_constants.h"
 
-// The maximum number of catpures that we will allow.
-const int PCRE_MAX_CAPTURE_GROUPS = 30;
+// Initial and maximum size of the machine stack used by JIT compiled code.
+// The default 32K stack PCRE provides is too small for some of the patterns
+// users create (nested repeats over whole chapters).
+const int PCRE_JIT_STACK_START_SIZE = 32 * 1024;
+const int PCRE_JIT_STACK_MAX_SIZE = 1024 * 1024;
+
+namespace
+{
+
+// A JIT stack can not be used by more than one thread at a time so
+// each thread that runs a match gets its own. It is freed when the
+// thread exits.
+struct JITStack {
+    pcre16_jit_stack *stack;
+
+    JITStack() {
+        stack = pcre16_jit_stack_alloc(PCRE_JIT_STACK_START_SIZE, PCRE_JIT_STACK_MAX_SIZE);
+    }
+    ~JITStack() {
+        if (stack != NULL) {
+            pcre16_jit_stack_free(stack);
+        }
+    }
+};
+
+QThreadStorage<JITStack *> g_JITStacks;
+
+// Called by pcre16_exec to get the stack for the current thread.
+// Returning NULL makes PCRE use its small default stack.
+pcre16_jit_stack *GetThreadJITStack(void *)
+{
+    if (!g_JITStacks.hasLocalData()) {
+        g_JITStacks.setLocalData(new JITStack());
+    }
+
+    return g_JITStacks.localData()->stack;
+}
+
+}
 
-SPCRE::SPCRE(const QString &patten)
+SPCRE::SPCRE(const QString &patten, bool use_jit)
 {
     m_pattern = patten;
     m_re = NULL;
     m_study = NULL;
     m_captureSubpatternCount = 0;
+    m_jit = false;
+    m_literal = NULL;
     const char *error;
     int erroroffset;
     m_re = pcre16_compile(m_pattern.utf16(), PCRE_UTF16 | PCRE_MULTILINE, &error, &erroroffset, NULL);
@@ -40,9 +82,35 @@ SPCRE::SPCRE(const QString &patten)
     if (m_re != NULL) {
         m_valid = true;
         // Study the pattern and save the results of the study.
-        m_study = pcre16_study(m_re, 0, &error);
+        int study_options = 0;
+
+        if (use_jit && isJITAvailable()) {
+            study_options |= PCRE_STUDY_JIT_COMPILE;
+        }
+
+        m_study = pcre16_study(m_re, study_options, &error);
+
+        // Not every pattern can be JIT compiled. When the JIT fails
+        // pcre16_exec silently uses the interpreter.
+        if (m_study != NULL && (study_options & PCRE_STUDY_JIT_COMPILE)) {
+            int jit_compiled = 0;
+            pcre16_fullinfo(m_re, m_study, PCRE_INFO_JIT, &jit_compiled);
+            m_jit = jit_compiled == 1;
+
+            if (m_jit) {
+                pcre16_assign_jit_stack(m_study, GetThreadJITStack, NULL);
+            }
+        }
         // Store the number of capture subpatterns.
         pcre16_fullinfo(m_re, m_study, PCRE_INFO_CAPTURECOUNT, &m_captureSubpatternCount);
+        // Plain text searches don't need PCRE to find matches. The
+        // compiled pattern is still kept for everything else.
+        QString literal;
+        bool caseless;
+
+        if (LiteralMatcher::ParsePattern(m_pattern, literal, caseless)) {
+            m_literal = new LiteralMatcher(literal, caseless);
+        }
     }
     // Pattern is not valid.
     else {
@@ -58,9 +126,14 @@ SPCRE::~SPCRE()
     }
 
     if (m_study != NULL) {
-        pcre16_free(m_study);
+        // The study must be freed with pcre16_free_study so any JIT
+        // compiled code is released as well.
+        pcre16_free_study(m_study);
         m_study = NULL;
     }
+
+    delete m_literal;
+    m_literal = NULL;
 }
 
 bool SPCRE::isValid()
@@ -83,6 +156,26 @@ pcre16_extra *SPCRE::getStudy()
     return m_study;
 }
 
+bool SPCRE::isJITCompiled()
+{
+    return m_jit;
+}
+
+bool SPCRE::isJITAvailable()
+{
+    static const bool jit_available = []() {
+        int available = 0;
+        pcre16_config(PCRE_CONFIG_JIT, &available);
+        return available == 1;
+    }();
+    return jit_available;
+}
+
+bool SPCRE::isLiteral()
+{
+    return m_literal != NULL;
+}
+
 int SPCRE::getCaptureSubpatternCount()
 {
     return m_captureSubpatternCount;
@@ -105,104 +198,68 @@ int SPCRE::getCaptureStringNumber(const QString &name)
 
 QList<SPCRE::MatchInfo> SPCRE::getEveryMatchInfo(const QString &text)
 {
-    // This function is very similar to getNextMatchInfo but we don't
-    // want to put a call to getNextMatchInfo in a loop because it allocates
-    // a new ovector. We want to avoid this and only do one allocation so we
-    // reuse the logic and put the call to generateMatchInfo in the loop.
     QList<SPCRE::MatchInfo> info;
+    MatchIterator it(*this, text);
 
-    if (m_re == NULL || text.isEmpty()) {
-        return info;
+    while (it.next()) {
+        info.append(it.matchInfo());
     }
 
-    int rc = 0;
-    // Set the size of the array based on the number of capture subpatterns
-    // if it does not exceed our maximum size.
-    int ovector_count = getCaptureSubpatternCount();
-
-    if (ovector_count > PCRE_MAX_CAPTURE_GROUPS) {
-        ovector_count = PCRE_MAX_CAPTURE_GROUPS;
-    }
-
-    // The vector needs to be a multiple of 3 and have at least one location
-    // for the full matched string.
-    int ovector_size = (1 + ovector_count) * 3;
-    // Allocate only the amount of memory we need for the search pattern and
-    // the number of capture patterns it contains.
-    // Can't use dynamic array alloction (int ovector[ovector_size]) because
-    // MSVC doesn't support it.
-    int *ovector = new int[ovector_size];
-    memset(ovector, 0, sizeof(int)*ovector_size);
-    // We keep track of the last offsets as we move though the string matching
-    // sub strings.
-    int last_offset[2] = {0};
-
-    // Run until no matches are found.
-    do {
-        // Store the matching offsets so we can tell when we need to quit this
-        // loop.
-        last_offset[0] = ovector[0];
-        last_offset[1] = ovector[1];
-
-        // We only care about matches that have text in it.
-        if (last_offset[0] != last_offset[1]) {
-            // Add the matched information to the list.
-            info.append(generateMatchInfo(ovector, ovector_count));
-        }
-
-        rc = pcre16_exec(m_re, m_study, text.utf16(), text.length(), last_offset[1], 0, ovector, ovector_size);
-    } while (rc >= 0 && ovector[0] != ovector[1] && ovector[1] != last_offset[1] && ovector[0] < ovector[1]);
-
-    delete[] ovector;
     return info;
 }
 
 SPCRE::MatchInfo SPCRE::getFirstMatchInfo(const QString &text)
 {
-    SPCRE::MatchInfo match_info;
+    MatchIterator it(*this, text);
 
-    if (m_re == NULL || text.isEmpty()) {
-        return match_info;
+    if (it.next()) {
+        return it.matchInfo();
     }
 
-    int rc = 0;
-    // Set the size of the array based on the number of capture subpatterns
-    // if it does not exceed our maximum size.
-    int ovector_count = getCaptureSubpatternCount();
+    return SPCRE::MatchInfo();
+}
 
-    if (ovector_count > PCRE_MAX_CAPTURE_GROUPS) {
-        ovector_count = PCRE_MAX_CAPTURE_GROUPS;
-    }
+SPCRE::MatchInfo SPCRE::getLastMatchInfo(const QString &text)
+{
+    // Only the offsets of the last match are needed so avoid building
+    // the capture groups for every match before it.
+    MatchIterator it(*this, text);
+    int last_start = -1;
 
-    // The vector needs to be a multiple of 3 and have at least one location
-    // for the full matched string.
-    int ovector_size = (1 + ovector_count) * 3;
-    // Allocate only the amount of memory we need for the search pattern and
-    // the number of capture patterns it contains.
-    // Can't use dynamic array alloction (int ovector[ovector_size]) because
-    // MSVC doesn't support it.
-    int *ovector = new int[ovector_size];
-    memset(ovector, 0, sizeof(int)*ovector_size);
-    rc = pcre16_exec(m_re, m_study, text.utf16(), text.length(), 0, 0, ovector, ovector_size);
+    while (it.next()) {
+        last_start = it.start();
+    }
 
-    if (rc >= 0 && ovector[0] != ovector[1]) {
-        match_info = generateMatchInfo(ovector, ovector_count);
+    if (last_start == -1) {
+        return SPCRE::MatchInfo();
     }
 
-    delete[] ovector;
-    return match_info;
+    // Rerun from the last match to get its capture groups.
+    MatchIterator last(*this, text, last_start);
+    last.next();
+    return last.matchInfo();
 }
 
-SPCRE::MatchInfo SPCRE::getLastMatchInfo(const QString &text)
+int SPCRE::getMatchCount(const QString &text)
 {
-    QList<SPCRE::MatchInfo> info;
-    info = getEveryMatchInfo(text);
+    MatchIterator it(*this, text);
+    int count = 0;
 
-    if (!info.isEmpty()) {
-        return info.last();
-    } else {
-        return SPCRE::MatchInfo();
+    while (it.next()) {
+        count++;
     }
+
+    return count;
+}
+
+bool SPCRE::hasMatch(const QString &text)
+{
+    if (m_re == NULL) {
+        return false;
+    }
+
+    int ovector[3];
+    return exec(text, 0, ovector, 3) >= 0;
 }
 
 bool SPCRE::replaceText(const QString &text, const QList<std::pair<int, int>> &capture_groups_offsets, const QString &replacement_pattern, QString &out)
@@ -211,7 +268,47 @@ bool SPCRE::replaceText(const QString &text, const QList<std::pair<int, int>> &c
     return builder.BuildReplacementText(*this, text, capture_groups_offsets, replacement_pattern, out);
 }
 
-SPCRE::MatchInfo SPCRE::generateMatchInfo(int ovector[], int ovector_count)
+int SPCRE::exec(const QString &text, int start_offset, int *ovector, int ovector_size)
+{
+    if (m_literal != NULL) {
+        int position = m_literal->IndexIn(text.utf16(), text.length(), start_offset);
+
+        if (position < 0) {
+            return PCRE_ERROR_NOMATCH;
+        }
+
+        ovector[0] = position;
+        ovector[1] = position + m_literal->Length();
+        return 1;
+    }
+
+    int rc = pcre16_exec(m_re, m_study, text.utf16(), text.length(), start_offset, 0, ovector, ovector_size);
+
+    if (rc == PCRE_ERROR_JIT_STACKLIMIT && m_study != NULL) {
+        // Run the same study through the interpreter by masking out the
+        // JIT code. The study data itself is still valid.
+        pcre16_extra interpreter_study = *m_study;
+        interpreter_study.flags &= ~PCRE_EXTRA_EXECUTABLE_JIT;
+        rc = pcre16_exec(m_re, &interpreter_study, text.utf16(), text.length(), start_offset, 0, ovector, ovector_size);
+    }
+
+    return rc;
+}
+
+int SPCRE::getOvectorCount()
+{
+    // Set the size of the array based on the number of capture subpatterns
+    // if it does not exceed our maximum size.
+    int ovector_count = getCaptureSubpatternCount();
+
+    if (ovector_count > PCRE_MAX_CAPTURE_GROUPS) {
+        ovector_count = PCRE_MAX_CAPTURE_GROUPS;
+    }
+
+    return ovector_count;
+}
+
+SPCRE::MatchInfo SPCRE::generateMatchInfo(const int ovector[], int ovector_count)
 {
     MatchInfo match_info;
     // Store the offsets in the QString text that we ar matching
@@ -236,3 +333,61 @@ SPCRE::MatchInfo SPCRE::generateMatchInfo(int ovector[], int ovector_count)
     return match_info;
 }
 
+
+SPCRE::MatchIterator::MatchIterator(SPCRE &sre, const QString &text, int start_offset)
+    :
+    m_sre(sre),
+    m_text(text),
+    m_ovectorCount(sre.getOvectorCount()),
+    m_lastEnd(start_offset),
+    m_done(sre.getCompiledPattern() == NULL || text.isEmpty())
+{
+    memset(m_ovector, 0, sizeof(m_ovector));
+}
+
+bool SPCRE::MatchIterator::next()
+{
+    if (m_done) {
+        return false;
+    }
+
+    // The vector needs to be a multiple of 3 and have at least one location
+    // for the full matched string.
+    int ovector_size = (1 + m_ovectorCount) * 3;
+    int rc = m_sre.exec(m_text, m_lastEnd, m_ovector, ovector_size);
+
+    // We only care about matches that have text in it. An empty match or
+    // no progress ends the search.
+    if (rc < 0 || m_ovector[0] >= m_ovector[1] || m_ovector[1] == m_lastEnd) {
+        m_done = true;
+        return false;
+    }
+
+    m_lastEnd = m_ovector[1];
+    return true;
+}
+
+int SPCRE::MatchIterator::start() const
+{
+    return m_ovector[0];
+}
+
+int SPCRE::MatchIterator::end() const
+{
+    return m_ovector[1];
+}
+
+int SPCRE::MatchIterator::captureCount() const
+{
+    return m_ovectorCount + 1;
+}
+
+std::pair<int, int> SPCRE::MatchIterator::captureOffsets(int group) const
+{
+    return std::pair<int, int>(m_ovector[2 * group] - m_ovector[0], m_ovector[2 * group + 1] - m_ovector[0]);
+}
+
+SPCRE::MatchInfo SPCRE::MatchIterator::matchInfo() const
+{
+    return m_sre.generateMatchInfo(m_ovector, m_ovectorCount);
+}
@@ -32,6 +32,11 @@
 
 using std::pair;
 
+class LiteralMatcher;
+
+// The maximum number of catpures that we will allow.
+const int PCRE_MAX_CAPTURE_GROUPS = 30;
+
 /**
  * Sigil Regular Expression object.
  *
@@ -48,8 +53,10 @@ public:
      * Constructor.
      *
      * @param pattern The search pattern.
+     * @param use_jit Study the pattern with the JIT compiler when the
+     * PCRE library supports it. Falls back to the interpreter otherwise.
      */
-    SPCRE(const QString &patten);
+    SPCRE(const QString &patten, bool use_jit = false);
     ~SPCRE();
 
     /**
@@ -72,6 +79,66 @@ public:
         }
     };
 
+    /**
+     * Walks the matches of the pattern in a piece of text one at a time.
+     *
+     * Unlike getEveryMatchInfo nothing is allocated while iterating. The
+     * ovector lives inside of the iterator and is reused for every match
+     * so callers can stop as soon as they have what they need.
+     *
+     * The iterator holds a reference to the SPCRE so the SPCRE must
+     * outlive it. The text is held by value (implicitly shared).
+     *
+     * Usage:
+     *     SPCRE::MatchIterator it(spcre, text);
+     *     while (it.next()) {
+     *         ... it.start(), it.end() ...
+     *     }
+     */
+    class MatchIterator
+    {
+    public:
+        MatchIterator(SPCRE &sre, const QString &text, int start_offset = 0);
+
+        /**
+         * Move to the next match.
+         *
+         * @return False when there are no more matches.
+         */
+        bool next();
+
+        /**
+         * Offset within the text where the current match starts.
+         */
+        int start() const;
+        /**
+         * Offset within the text where the current match ends.
+         */
+        int end() const;
+        /**
+         * The number of capture groups available including the
+         * full match as group 0.
+         */
+        int captureCount() const;
+        /**
+         * The offsets of a capture group relative to the start of
+         * the match. Same as MatchInfo::capture_groups_offsets.
+         */
+        std::pair<int, int> captureOffsets(int group) const;
+        /**
+         * Create a MatchInfo for the current match.
+         */
+        MatchInfo matchInfo() const;
+
+    private:
+        SPCRE &m_sre;
+        QString m_text;
+        int m_ovector[(1 + PCRE_MAX_CAPTURE_GROUPS) * 3];
+        int m_ovectorCount;
+        int m_lastEnd;
+        bool m_done;
+    };
+
     /**
      * Is the pattern valid.
      *
@@ -98,6 +165,25 @@ public:
      * @return The study result.
      */
     pcre16_extra *getStudy();
+    /**
+     * Was the pattern successfully compiled to native code by the JIT.
+     *
+     * @return True if matching will use the JIT compiled code.
+     */
+    bool isJITCompiled();
+    /**
+     * Is the JIT compiler available in the PCRE library we are linked to.
+     *
+     * @return True if patterns can be JIT compiled.
+     */
+    static bool isJITAvailable();
+    /**
+     * Is the pattern plain text. These patterns are matched with a
+     * substring search instead of PCRE.
+     *
+     * @return True if the pattern has no regular expression syntax.
+     */
+    bool isLiteral();
     /**
      * The total number of capture subpatterns within the pattern.
      *
@@ -126,6 +212,18 @@ public:
     MatchInfo getFirstMatchInfo(const QString &text);
     MatchInfo getLastMatchInfo(const QString &text);
 
+    /**
+     * The number of matches in the text. Counts the same matches
+     * getEveryMatchInfo would return without storing them.
+     */
+    int getMatchCount(const QString &text);
+
+    /**
+     * Does the pattern match anywhere in the text. Unlike the other
+     * functions an empty match also counts as a match.
+     */
+    bool hasMatch(const QString &text);
+
     /**
      * Replaces the given text using a replacement pattern. The matched text is
      * required because the replacement pattern can references the capture
@@ -143,7 +241,20 @@ public:
     bool replaceText(const QString &text, const QList<std::pair<int, int>> &capture_groups_offsets, const QString &replacement_pattern, QString &out);
 
 private:
-    MatchInfo generateMatchInfo(int ovector[], int ovector_count);
+    MatchInfo generateMatchInfo(const int ovector[], int ovector_count);
+
+    /**
+     * Wrapper around pcre16_exec. Literal patterns are searched for
+     * without PCRE. If the JIT runs out of stack on a pathological
+     * pattern the match is retried with the interpreter.
+     */
+    int exec(const QString &text, int start_offset, int *ovector, int ovector_size);
+
+    /**
+     * The number of capture groups to store offsets for. Limited to
+     * PCRE_MAX_CAPTURE_GROUPS.
+     */
+    int getOvectorCount();
 
     // Store if the pattern is valid.
     bool m_valid;
@@ -155,6 +266,11 @@ private:
     pcre16_extra *m_study;
     // The number of capture subpatterns with the expression.
     int m_captureSubpatternCount;
+    // Whether the study holds JIT compiled code.
+    bool m_jit;
+    // Substring search used in place of PCRE for literal patterns.
+    // NULL if the pattern is not a literal.
+    LiteralMatcher *m_literal;
 };
 
 #endif // SPCRE_H
@@ -0,0 +1,432 @@
+/************************************************************************
+**
+**  Copyright (C) 2016-2020 Kevin B. Hendricks, Stratford Ontario Canada
+**  Copyright (C) 2016-2020 Doug Massay
+**
+**  This file is part of Sigil.
+**
+**  Sigil is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  Sigil is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with Sigil.  If not, see <http://www.gnu.org/licenses/>.
+**
+*************************************************************************/
+
+#include <utility>
+
+#include <QString>
+#include <QStringList>
+#include <QHash>
+#include <QSet>
+#include <QRegularExpression>
+#include <QRegularExpressionMatch>
+
+#include "ResourceObjects/OPFParser.h"
+#include "ResourceObjects/MetadataProcessor.h"
+
+static const QString METADATA_PATTERN = "<\\s*metadata[^>]*>.*<\\s*/\\s*metadata\\s*>\\s*";
+
+// record separator, unit separator and the indent that
+// marks an attribute or refinement as child of the record above
+static const QChar RS = QChar(30);
+static const QChar US = QChar(31);
+static const QString IN = "  ";
+
+static const QStringList RECOGNIZED_DC = QStringList() << "dc:identifier" << "dc:title"
+                                                       << "dc:creator" << "dc:contributor"
+                                                       << "dc:source" << "dc:date"
+                                                       << "dc:language" << "dc:coverage"
+                                                       << "dc:description" << "dc:format"
+                                                       << "dc:publisher" << "dc:relation"
+                                                       << "dc:rights" << "dc:subject"
+                                                       << "dc:type";
+
+// epub3 primary meta properties shown as elements of their own
+static const QStringList RECOGNIZED_META = QStringList() << "belongs-to-collection"
+                                                         << "dcterms:issued"
+                                                         << "dcterms:created";
+
+// epub2 named meta tags left alone
+static const QStringList SKIP_META = QStringList() << "cover";
+
+// refinements that carry the scheme of their value
+static const QStringList SCHEMED_REFINES = QStringList() << "role" << "identifier-type"
+                                                         << "title-type" << "collection-type";
+
+// id roots for recognized elements that need an id for their refinements
+static const QHash<QString, QString> REC2ROOT = {
+    { "dc:identifier",  "uid" },
+    { "dc:title",       "tle" },
+    { "dc:creator",     "cre" },
+    { "dc:contributor", "con" },
+    { "dc:source",      "src" },
+    { "dc:date",        "dat" },
+    { "dc:language",    "lng" },
+    { "dc:coverage",    "cov" },
+    { "dc:description", "des" },
+    { "dc:format",      "fmt" },
+    { "dc:publisher",   "pub" },
+    { "dc:relation",    "rln" },
+    { "dc:rights",      "rgt" },
+    { "dc:subject",     "sub" },
+    { "dc:type",        "typ" },
+};
+
+typedef QList<std::pair<QString, QString>> MetaAttributes;
+
+
+static QString XMLEncode(const QString &data)
+{
+    QString newdata = data;
+    newdata.replace("&", "&amp;");
+    newdata.replace("<", "&lt;");
+    newdata.replace(">", "&gt;");
+    newdata.replace("\"", "&quot;");
+    return newdata;
+}
+
+
+static QString XMLDecode(const QString &data)
+{
+    QString newdata = data;
+    newdata.replace("&quot;", "\"");
+    newdata.replace("&gt;", ">");
+    newdata.replace("&lt;", "<");
+    newdata.replace("&amp;", "&");
+    return newdata;
+}
+
+
+// Attributes keep the order they are set in, setting one again replaces its value.
+static void SetAttribute(MetaAttributes &atts, const QString &key, const QString &value)
+{
+    for (int i = 0; i < atts.count(); ++i) {
+        if (atts.at(i).first == key) {
+            atts[i].second = value;
+            return;
+        }
+    }
+    atts.append(std::make_pair(key, value));
+}
+
+
+static bool HasAttribute(const MetaAttributes &atts, const QString &key)
+{
+    for (int i = 0; i < atts.count(); ++i) {
+        if (atts.at(i).first == key) {
+            return true;
+        }
+    }
+    return false;
+}
+
+
+static QString AttributeValue(const MetaAttributes &atts, const QString &key)
+{
+    for (int i = 0; i < atts.count(); ++i) {
+        if (atts.at(i).first == key) {
+            return atts.at(i).second;
+        }
+    }
+    return QString();
+}
+
+
+// Returns id, or id with a numeric suffix if it is already in use,
+// and marks the result as in use.
+static QString ValidId(const QString &id, QSet<QString> &ids)
+{
+    int pos = 1;
+    QString nid = id;
+    while (ids.contains(nid)) {
+        nid = id + QString("%1").arg(pos, 3, 10, QChar('0'));
+        pos++;
+    }
+    ids.insert(nid);
+    return nid;
+}
+
+
+// Builds a metadata element from unescaped content and attribute values.
+static QString BuildXML(const QString &name, const QString &content, bool has_content, const MetaAttributes &atts)
+{
+    QString xml = IN + "<" + name;
+    for (int i = 0; i < atts.count(); ++i) {
+        xml += " " + atts.at(i).first + "=\"" + XMLEncode(atts.at(i).second) + "\"";
+    }
+    if (has_content) {
+        xml += ">" + XMLEncode(content) + "</" + name + ">\n";
+    } else {
+        xml += " />\n";
+    }
+    return xml;
+}
+
+
+// Writes an unrecognized element back as it was parsed, its content
+// and attribute values are still escaped.
+static QString RawXML(const MetaEntry &me)
+{
+    QString xml = IN + "<" + me.m_name;
+    foreach(QString key, me.m_atts.keys()) {
+        QString val = me.m_atts.value(key);
+        val.replace("\"", "&quot;");
+        xml += " " + key + "=\"" + val + "\"";
+    }
+    if (me.m_content.isEmpty()) {
+        xml += " />\n";
+    } else {
+        xml += ">" + me.m_content + "</" + me.m_name + ">\n";
+    }
+    return xml;
+}
+
+
+static QStringList CollectIds(const OPFParser &opf)
+{
+    QStringList ids;
+    if (opf.m_package.m_atts.contains("id")) {
+        ids << opf.m_package.m_atts.value("id");
+    }
+    if (opf.m_metans.m_atts.contains("id")) {
+        ids << opf.m_metans.m_atts.value("id");
+    }
+    for (int i = 0; i < opf.m_metadata.count(); ++i) {
+        if (opf.m_metadata.at(i).m_atts.contains("id")) {
+            ids << opf.m_metadata.at(i).m_atts.value("id");
+        }
+    }
+    for (int i = 0; i < opf.m_manifest.count(); ++i) {
+        ids << opf.m_manifest.at(i).m_id;
+    }
+    if (opf.m_spineattr.m_atts.contains("id")) {
+        ids << opf.m_spineattr.m_atts.value("id");
+    }
+    for (int i = 0; i < opf.m_spine.count(); ++i) {
+        if (opf.m_spine.at(i).m_atts.contains("id")) {
+            ids << opf.m_spine.at(i).m_atts.value("id");
+        }
+    }
+    return ids;
+}
+
+
+MetadataPieces MetadataProcessor::GetMetadata(const OPFParser &opf, const QString &version)
+{
+    bool epub3 = version.startsWith('3');
+    MetadataPieces mdp;
+    QList<MetaEntry> rec;
+    QList<MetaEntry> refines;
+    QList<MetaEntry> other;
+    QHash<QString, int> id2rec;
+    // ids moved over to the recognized metadata, they are handed out again on save
+    QHash<QString, int> owned;
+    QString uid = opf.m_package.m_uniqueid;
+
+    for (int i = 0; i < opf.m_metadata.count(); ++i) {
+        MetaEntry me(opf.m_metadata.at(i));
+        bool recognized = false;
+
+        // do not let the editor touch the unique-identifier
+        // as font obfuscation depends on it
+        if (me.m_name == "dc:identifier" && me.m_atts.value("id") == uid) {
+            other << me;
+            continue;
+        }
+        if (RECOGNIZED_DC.contains(me.m_name)) {
+            recognized = true;
+        } else if (epub3 && me.m_name == "meta" && me.m_atts.contains("refines")) {
+            refines << me;
+        } else if (epub3 && me.m_name == "meta" && me.m_atts.contains("property")) {
+            QString property = me.m_atts.value("property");
+            if (RECOGNIZED_META.contains(property)) {
+                me.m_atts.remove("property");
+                me.m_name = property;
+            }
+            recognized = true;
+        } else if (!epub3 && me.m_name == "meta" && me.m_atts.contains("name") &&
+                   !SKIP_META.contains(me.m_atts.value("name"))) {
+            me.m_name = me.m_atts.take("name");
+            me.m_content = me.m_atts.take("content");
+            recognized = true;
+        } else {
+            other << me;
+        }
+        if (recognized) {
+            if (me.m_atts.contains("id")) {
+                QString id = me.m_atts.value("id");
+                id2rec[id] = rec.count();
+                owned[id]++;
+            }
+            rec << me;
+        }
+    }
+
+    // fold refinements of recognized metadata into attributes of their target,
+    // anything else they refine is left alone
+    foreach(MetaEntry me, refines) {
+        QString tid = me.m_atts.value("refines");
+        QString prop = me.m_atts.value("property");
+        if (!tid.startsWith('#') || !id2rec.contains(tid.mid(1)) || prop.isEmpty()) {
+            other << me;
+            continue;
+        }
+        MetaEntry &target = rec[id2rec.value(tid.mid(1))];
+        target.m_atts[prop] = me.m_content;
+        if (me.m_atts.contains("scheme")) {
+            target.m_atts["scheme"] = me.m_atts.value("scheme");
+        }
+        if (prop == "alternate-script" && !me.m_atts.value("xml:lang").isEmpty()) {
+            target.m_atts["altlang"] = me.m_atts.value("xml:lang");
+        }
+        if (me.m_atts.contains("id")) {
+            owned[me.m_atts.value("id")]++;
+        }
+    }
+
+    QStringList data;
+    foreach(MetaEntry me, rec) {
+        data << me.m_name + US + XMLDecode(me.m_content) + RS;
+        QStringList keys = me.m_atts.keys();
+        keys.sort();
+        foreach(QString key, keys) {
+            data << IN + key + US + XMLDecode(me.m_atts.value(key)) + RS;
+        }
+    }
+    mdp.data = data.join("");
+
+    QStringList otherxml;
+    foreach(MetaEntry me, other) {
+        otherxml << RawXML(me);
+    }
+    mdp.otherxml = otherxml.join("");
+
+    foreach(QString id, CollectIds(opf)) {
+        if (owned.value(id, 0) > 0) {
+            owned[id]--;
+            continue;
+        }
+        mdp.idlist << id;
+    }
+
+    // epub2 metadata needs the opf and dc namespaces on the metadata tag
+    QHash<QString, QString> metaatts = opf.m_metans.m_atts;
+    if (!epub3) {
+        if (!metaatts.contains("xmlns:opf")) {
+            metaatts["xmlns:opf"] = "http://www.idpf.org/2007/opf";
+        }
+        if (!metaatts.contains("xmlns:dc")) {
+            metaatts["xmlns:dc"] = "http://purl.org/dc/elements/1.1/";
+        }
+    }
+    QString metatag = "<metadata";
+    foreach(QString key, metaatts.keys()) {
+        QString val = metaatts.value(key);
+        val.replace("\"", "&quot;");
+        metatag += " " + key + "=\"" + val + "\"";
+    }
+    mdp.metatag = metatag + ">\n";
+    return mdp;
+}
+
+
+QString MetadataProcessor::SetNewMetadata(const MetadataPieces &mdp, const QString &opfdata, const QString &version)
+{
+    bool epub3 = version.startsWith('3');
+    QSet<QString> ids;
+    foreach(QString id, mdp.idlist) {
+        ids.insert(id);
+    }
+
+    QStringList records = mdp.data.split(RS);
+    if (!records.isEmpty() && records.last().isEmpty()) {
+        records.removeLast();
+    }
+
+    QStringList newmd;
+    int pos = 0;
+    int cnt = records.count();
+    while (pos < cnt) {
+        // always starts with a parent who may or may not have any children
+        QString name = records.at(pos).section(US, 0, 0).trimmed();
+        QString content = records.at(pos).section(US, 1).trimmed();
+        bool has_content = true;
+        QString id;
+        MetaAttributes atts;
+        MetaAttributes refinements;
+
+        if (epub3) {
+            if (RECOGNIZED_META.contains(name)) {
+                SetAttribute(atts, "property", name);
+                name = "meta";
+            }
+        } else if (!RECOGNIZED_DC.contains(name)) {
+            SetAttribute(atts, "name", name);
+            SetAttribute(atts, "content", content);
+            name = "meta";
+            has_content = false;
+        }
+        pos++;
+
+        while (pos < cnt && records.at(pos).startsWith(IN)) {
+            QString key = records.at(pos).section(US, 0, 0).trimmed();
+            QString value = records.at(pos).section(US, 1).trimmed();
+            if (key == "id") {
+                id = ValidId(value, ids);
+                SetAttribute(atts, "id", id);
+            } else if (!epub3 || key == "xml:lang" || key == "dir" || (name == "meta" && key == "property")) {
+                SetAttribute(atts, key, value);
+            } else {
+                SetAttribute(refinements, key, value);
+            }
+            pos++;
+        }
+
+        // refinements need an id to point at
+        if (!refinements.isEmpty() && !HasAttribute(atts, "id")) {
+            id = ValidId(REC2ROOT.value(name, "num"), ids);
+            SetAttribute(atts, "id", id);
+        }
+
+        newmd << BuildXML(name, content, has_content, atts);
+
+        for (int i = 0; i < refinements.count(); ++i) {
+            QString prop = refinements.at(i).first;
+            if (prop == "scheme" || prop == "altlang") {
+                continue;
+            }
+            MetaAttributes ratts;
+            SetAttribute(ratts, "refines", "#" + id);
+            SetAttribute(ratts, "property", prop);
+            // an alternate script without a language gets no xml:lang at all
+            if (prop == "alternate-script" && !AttributeValue(refinements, "altlang").isEmpty()) {
+                SetAttribute(ratts, "xml:lang", AttributeValue(refinements, "altlang"));
+            }
+            if (SCHEMED_REFINES.contains(prop) && HasAttribute(refinements, "scheme")) {
+                SetAttribute(ratts, "scheme", AttributeValue(refinements, "scheme"));
+            }
+            newmd << BuildXML("meta", refinements.at(i).second, true, ratts);
+        }
+    }
+
+    // rebuild the entire metadata section
+    QString newmetadata = mdp.metatag + newmd.join("") + mdp.otherxml + "</metadata>\n";
+    QRegularExpression metadata_re(METADATA_PATTERN,
+                                   QRegularExpression::CaseInsensitiveOption |
+                                   QRegularExpression::DotMatchesEverythingOption);
+    QRegularExpressionMatch match = metadata_re.match(opfdata);
+    if (!match.hasMatch()) {
+        return opfdata;
+    }
+    QString newopfdata = opfdata;
+    newopfdata.replace(match.capturedStart(), match.capturedLength(), newmetadata);
+    return newopfdata;
+}
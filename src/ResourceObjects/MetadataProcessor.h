@@ -0,0 +1,75 @@
+/************************************************************************
+**
+**  Copyright (C) 2016-2020 Kevin B. Hendricks, Stratford Ontario Canada
+**  Copyright (C) 2016-2020 Doug Massay
+**
+**  This file is part of Sigil.
+**
+**  Sigil is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  Sigil is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with Sigil.  If not, see <http://www.gnu.org/licenses/>.
+**
+*************************************************************************/
+
+#pragma once
+#ifndef METADATAPROCESSOR_H
+#define METADATAPROCESSOR_H
+
+#include <QString>
+#include <QStringList>
+
+struct OPFParser;
+
+/**
+ * The metadata of an opf split up for the Metadata Editor.
+ */
+struct MetadataPieces {
+    // recognized metadata as a text tree, one record per element or
+    // attribute/refinement with children indented under their parent
+    QString data;
+    // all other metadata as xml, it is written back untouched
+    QString otherxml;
+    // the ids in use in the opf that the recognized metadata does not own
+    QStringList idlist;
+    // the opening metadata tag with its namespace attributes
+    QString metatag;
+};
+
+/**
+ * Converts opf metadata to and from the text tree the Metadata Editor
+ * works on. Epub3 refinements are folded into attributes of the element
+ * they refine on the way out and written back as <meta refines> on the
+ * way in. Epub2 <meta name content> pairs become elements of their own.
+ */
+class MetadataProcessor
+{
+public:
+    /**
+     * Splits the metadata of a parsed opf into the editor pieces.
+     *
+     * @param opf The parsed opf.
+     * @param version The epub version of the book.
+     */
+    static MetadataPieces GetMetadata(const OPFParser &opf, const QString &version);
+
+    /**
+     * Rebuilds the metadata section from the edited pieces.
+     *
+     * @param mdp The pieces, with data edited by the user.
+     * @param opfdata The opf source whose metadata section is replaced.
+     * @param version The epub version of the book.
+     * @return The new opf source.
+     */
+    static QString SetNewMetadata(const MetadataPieces &mdp, const QString &opfdata, const QString &version);
+};
+
+#endif // METADATAPROCESSOR_H
@@ -27,6 +27,8 @@
 
 #include "BookManipulation/CleanSource.h"
 #include "Exporters/NCXWriter.h"
+#include "ResourceObjects/HTMLResource.h"
+#include "ResourceObjects/NavProcessor.h"
 #include "ResourceObjects/NCXResource.h"
 #include "Misc/SettingsStore.h"
 #include "Misc/Utility.h"
@@ -161,6 +163,20 @@ void NCXResource::GenerateNCXFromTOCEntries(const Book *book, TOCModel::TOCEntry
 }
 
 
+void NCXResource::GenerateNCXFromNav(const Book *book, HTMLResource *nav_resource)
+{
+    NavProcessor navproc(nav_resource);
+    QByteArray raw_ncx;
+    QBuffer buffer(&raw_ncx);
+    buffer.open(QIODevice::WriteOnly);
+    NCXWriter ncx(book, buffer, navproc.GetRootTOCEntry());
+    ncx.SetPageList(navproc.GetPageListBookPaths());
+    ncx.WriteXML();
+    buffer.close();
+    SetText(CleanSource::ProcessXML(QString::fromUtf8(raw_ncx.constData(), raw_ncx.size()), "application/x-dtbncx+xml"));
+}
+
+
 void NCXResource::FillWithDefaultText(const QString &version, const QString &default_text_folder)
 {
     QString first_section_bookpath = FIRST_SECTION_NAME;
@@ -28,6 +28,7 @@
 #include "ResourceObjects/XMLResource.h"
 
 class Book;
+class HTMLResource;
 
 class NCXResource : public XMLResource
 {
@@ -60,6 +61,11 @@ public:
     bool GenerateNCXFromBookContents(const Book *book);
     void GenerateNCXFromTOCContents(const Book *book, TOCModel *toc_model);
     void GenerateNCXFromTOCEntries(const Book *book, TOCModel::TOCEntry toc_root_entry);
+
+    /**
+     * Writes the NCX from the toc and page-list of an epub3 nav.
+     */
+    void GenerateNCXFromNav(const Book *book, HTMLResource *nav_resource);
     void FillWithDefaultText(const QString &version, const QString &default_text_folder);
     void FillWithDefaultTextToBookPath(const QString &version, const QString &start_bookpath);
 };
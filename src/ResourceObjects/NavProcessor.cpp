@@ -185,6 +185,16 @@ QList<NavPageListEntry> NavProcessor::GetPageList()
 }
 
 
+QList<NavPageListEntry> NavProcessor::GetPageListBookPaths()
+{
+    QList<NavPageListEntry> pagelist = GetPageList();
+    for (int i = 0; i < pagelist.size(); ++i) {
+        pagelist[i].href = ConvertHREFToBookPath(pagelist[i].href);
+    }
+    return pagelist;
+}
+
+
 QList<NavTOCEntry> NavProcessor::GetTOC()
 {
     QList<NavTOCEntry> toclist;
@@ -58,6 +58,9 @@ public:
     QList<NavLandmarkEntry> GetLandmarks();
     QList<NavPageListEntry> GetPageList();
 
+    // page-list with its hrefs converted to book paths (plus any fragment)
+    QList<NavPageListEntry> GetPageListBookPaths();
+
     // Set Nav Section from Actual Book Headings
     bool GenerateTOCFromBookContents(const Book* book);
 
@@ -184,9 +184,8 @@ void OPFResource::SetText(const QString &text)
 QList<Resource*> OPFResource::GetSpineOrderResources( const QList<Resource *> &resources)
 {
     QReadLocker locker(&GetLock());
-    QString source = CleanSource::ProcessXML(GetText(),"application/oebps-package+xml");
-    OPFParser p;
-    p.parse(source);
+    QSharedPointer<const OPFParser> parsed = GetParsedOPF();
+    const OPFParser &p = *parsed;
     const QHash<QString, Resource*> id_mapping = GetManifestIDResourceMapping(resources, p);
     QList<Resource *> spine_order;
     for (int i = 0; i < p.m_spine.count(); ++i) {
@@ -201,9 +200,8 @@ QList<Resource*> OPFResource::GetSpineOrderResources( const QList<Resource *> &r
 QHash <Resource *, int>  OPFResource::GetReadingOrderAll( const QList <Resource *> resources)
 {
     QReadLocker locker(&GetLock());
-    QString source = CleanSource::ProcessXML(GetText(),"application/oebps-package+xml");
-    OPFParser p;
-    p.parse(source);
+    QSharedPointer<const OPFParser> parsed = GetParsedOPF();
+    const OPFParser &p = *parsed;
     QHash <Resource *, int> reading_order;
     QHash<QString, int> id_order;
     for (int i = 0; i < p.m_spine.count(); ++i) {
@@ -220,9 +218,8 @@ QHash <Resource *, int>  OPFResource::GetReadingOrderAll( const QList <Resource
 int OPFResource::GetReadingOrder(const HTMLResource *html_resource) const
 {
     QReadLocker locker(&GetLock());
-    QString source = CleanSource::ProcessXML(GetText(),"application/oebps-package+xml");
-    OPFParser p;
-    p.parse(source);
+    QSharedPointer<const OPFParser> parsed = GetParsedOPF();
+    const OPFParser &p = *parsed;
     const Resource *resource = static_cast<const Resource *>(html_resource);
     QString resource_id = GetResourceManifestID(resource, p);
     for (int i = 0; i < p.m_spine.count(); ++i) {
@@ -237,9 +234,8 @@ int OPFResource::GetReadingOrder(const HTMLResource *html_resource) const
 QString OPFResource::GetMainIdentifierValue() const
 {
     QReadLocker locker(&GetLock());
-    QString source = CleanSource::ProcessXML(GetText(),"application/oebps-package+xml");
-    OPFParser p;
-    p.parse(source);
+    QSharedPointer<const OPFParser> parsed = GetParsedOPF();
+    const OPFParser &p = *parsed;
     int i = GetMainIdentifier(p);
     if (i > -1) {
         return QString(p.m_metadata.at(i).m_content);
@@ -285,9 +281,8 @@ QString OPFResource::GetUUIDIdentifierValue()
 {
     EnsureUUIDIdentifierPresent();
     QReadLocker locker(&GetLock());
-    QString source = CleanSource::ProcessXML(GetText(),"application/oebps-package+xml");
-    OPFParser p;
-    p.parse(source);
+    QSharedPointer<const OPFParser> parsed = GetParsedOPF();
+    const OPFParser &p = *parsed;
     for (int i=0; i < p.m_metadata.count(); ++i) {
         MetaEntry me = p.m_metadata.at(i);
         if(me.m_name.startsWith("dc:identifier")) {
@@ -307,9 +302,7 @@ QString OPFResource::GetUUIDIdentifierValue()
 void OPFResource::EnsureUUIDIdentifierPresent()
 {
     QWriteLocker locker(&GetLock());
-    QString source = CleanSource::ProcessXML(GetText(),"application/oebps-package+xml");
-    OPFParser p;
-    p.parse(source);
+    OPFParser p = *GetParsedOPF();
     for (int i=0; i < p.m_metadata.count(); ++i) {
         MetaEntry me = p.m_metadata.at(i);
         if(me.m_name.startsWith("dc:identifier")) {
@@ -329,9 +322,7 @@ void OPFResource::EnsureUUIDIdentifierPresent()
 QString OPFResource::AddNCXItem(const QString &ncx_path, QString id)
 {
     QWriteLocker locker(&GetLock());
-    QString source = CleanSource::ProcessXML(GetText(),"application/oebps-package+xml");
-    OPFParser p;
-    p.parse(source);
+    OPFParser p = *GetParsedOPF();
     QString ncx_bkpath = ncx_path.right(ncx_path.length() - GetFullPathToBookFolder().length() - 1);
     QString ncx_rel_path = Utility::buildRelativePath(GetRelativePath(), ncx_bkpath);
     int n = p.m_manifest.count();
@@ -350,9 +341,7 @@ QString OPFResource::AddNCXItem(const QString &ncx_path, QString id)
 void OPFResource::UpdateNCXOnSpine(const QString &new_ncx_id)
 {
     QWriteLocker locker(&GetLock());
-    QString source = CleanSource::ProcessXML(GetText(),"application/oebps-package+xml");
-    OPFParser p;
-    p.parse(source);
+    OPFParser p = *GetParsedOPF();
     QString ncx_id = p.m_spineattr.m_atts.value(QString("toc"),"");
     if (new_ncx_id != ncx_id) {
         p.m_spineattr.m_atts[QString("toc")] = new_ncx_id;
@@ -363,9 +352,7 @@ void OPFResource::UpdateNCXOnSpine(const QString &new_ncx_id)
 void OPFResource::RemoveNCXOnSpine()
 {
     QWriteLocker locker(&GetLock());
-    QString source = CleanSource::ProcessXML(GetText(),"application/oebps-package+xml");
-    OPFParser p;
-    p.parse(source);
+    OPFParser p = *GetParsedOPF();
     p.m_spineattr.m_atts.remove("toc");
     UpdateText(p);
 }
@@ -374,9 +361,7 @@ void OPFResource::RemoveNCXOnSpine()
 void OPFResource::UpdateNCXLocationInManifest(const NCXResource *ncx)
 {
     QWriteLocker locker(&GetLock());
-    QString source = CleanSource::ProcessXML(GetText(),"application/oebps-package+xml");
-    OPFParser p;
-    p.parse(source);
+    OPFParser p = *GetParsedOPF();
     QString ncx_id = p.m_spineattr.m_atts.value(QString("toc"), "");
     int pos = p.m_idpos.value(ncx_id, -1);
     if (pos > -1) {
@@ -395,9 +380,7 @@ void OPFResource::UpdateNCXLocationInManifest(const NCXResource *ncx)
 void OPFResource::AddSigilVersionMeta()
 {
     QWriteLocker locker(&GetLock());
-    QString source = CleanSource::ProcessXML(GetText(),"application/oebps-package+xml");
-    OPFParser p;
-    p.parse(source);
+    OPFParser p = *GetParsedOPF();
     for (int i=0; i < p.m_metadata.count(); ++i) {
         MetaEntry me = p.m_metadata.at(i);
         if ((me.m_name == "meta") && (me.m_atts.contains("name"))) {  
@@ -422,9 +405,8 @@ void OPFResource::AddSigilVersionMeta()
 bool OPFResource::IsCoverImage(const ImageResource *image_resource) const
 {
     QReadLocker locker(&GetLock());
-    QString source = CleanSource::ProcessXML(GetText(),"application/oebps-package+xml");
-    OPFParser p;
-    p.parse(source);
+    QSharedPointer<const OPFParser> parsed = GetParsedOPF();
+    const OPFParser &p = *parsed;
     QString resource_id = GetResourceManifestID(image_resource, p);
     return IsCoverImageCheck(resource_id, p);
 }
@@ -444,9 +426,8 @@ bool OPFResource::IsCoverImageCheck(QString resource_id, const OPFParser & p) co
 bool OPFResource::CoverImageExists() const
 {
     QReadLocker locker(&GetLock());
-    QString source = CleanSource::ProcessXML(GetText(),"application/oebps-package+xml");
-    OPFParser p;
-    p.parse(source);
+    QSharedPointer<const OPFParser> parsed = GetParsedOPF();
+    const OPFParser &p = *parsed;
     return GetCoverMeta(p) > -1;
 }
 
@@ -462,9 +443,8 @@ void OPFResource::AutoFixWellFormedErrors()
 QStringList OPFResource::GetSpineOrderBookPaths() const
 {
     QReadLocker locker(&GetLock());
-    QString source = CleanSource::ProcessXML(GetText(),"application/oebps-package+xml");
-    OPFParser p;
-    p.parse(source);
+    QSharedPointer<const OPFParser> parsed = GetParsedOPF();
+    const OPFParser &p = *parsed;
     QStringList book_paths_in_reading_order;
     for (int i=0; i < p.m_spine.count(); ++i) {
         SpineEntry sp = p.m_spine.at(i);
@@ -492,9 +472,8 @@ QString OPFResource::GetPrimaryBookLanguage() const
 QList<MetaEntry> OPFResource::GetDCMetadata() const
 {
     QReadLocker locker(&GetLock());
-    QString source = CleanSource::ProcessXML(GetText(),"application/oebps-package+xml");
-    OPFParser p;
-    p.parse(source);
+    QSharedPointer<const OPFParser> parsed = GetParsedOPF();
+    const OPFParser &p = *parsed;
     QList<MetaEntry> metadata;
     for (int i=0; i < p.m_metadata.count(); ++i) {
         if (p.m_metadata.at(i).m_name.startsWith("dc:")) {
@@ -506,6 +485,14 @@ QList<MetaEntry> OPFResource::GetDCMetadata() const
 }
 
 
+MetadataPieces OPFResource::GetMetadataPieces() const
+{
+    QReadLocker locker(&GetLock());
+    QSharedPointer<const OPFParser> parsed = GetParsedOPF();
+    return MetadataProcessor::GetMetadata(*parsed, GetEpubVersion());
+}
+
+
 QList<QVariant> OPFResource::GetDCMetadataValues(QString text) const
 {
     QList<QVariant> values;
@@ -521,9 +508,7 @@ QList<QVariant> OPFResource::GetDCMetadataValues(QString text) const
 void OPFResource::SetDCMetadata(const QList<MetaEntry> &metadata)
 {
     QWriteLocker locker(&GetLock());
-    QString source = CleanSource::ProcessXML(GetText(),"application/oebps-package+xml");
-    OPFParser p;
-    p.parse(source);
+    OPFParser p = *GetParsedOPF();
     // this will not work with refines so it needs to be fixed
     RemoveDCElements(p);
     foreach(MetaEntry book_meta, metadata) {
@@ -538,9 +523,7 @@ void OPFResource::SetDCMetadata(const QList<MetaEntry> &metadata)
 void OPFResource::AddResource(const Resource *resource)
 {
     QWriteLocker locker(&GetLock());
-    QString source = CleanSource::ProcessXML(GetText(),"application/oebps-package+xml");
-    OPFParser p;
-    p.parse(source);
+    OPFParser p = *GetParsedOPF();
     ManifestEntry me;
     me.m_id = GetUniqueID(GetValidID(resource->Filename()),p);
     me.m_href = GetRelativePathToResource(resource);
@@ -645,9 +628,7 @@ void OPFResource::AddCoverMetaForImage(const Resource *resource, OPFParser &p)
 void OPFResource::RemoveResource(const Resource *resource)
 {
     QWriteLocker locker(&GetLock());
-    QString source = CleanSource::ProcessXML(GetText(),"application/oebps-package+xml");
-    OPFParser p;
-    p.parse(source);
+    OPFParser p = *GetParsedOPF();
     if (p.m_manifest.isEmpty()) return;
     QString href = GetRelativePathToResource(resource);
     int pos = p.m_hrefpos.value(href, -1);
@@ -692,9 +673,7 @@ void OPFResource::RemoveResource(const Resource *resource)
 void OPFResource::ClearSemanticCodesInGuide()
 {
     QWriteLocker locker(&GetLock());
-    QString source = CleanSource::ProcessXML(GetText(),"application/oebps-package+xml");
-    OPFParser p;
-    p.parse(source);
+    OPFParser p = *GetParsedOPF();
     foreach(GuideEntry ge, p.m_guide) {
         p.m_guide.removeAt(0);
     }
@@ -707,9 +686,7 @@ void OPFResource::AddGuideSemanticCode(HTMLResource *html_resource, QString new_
     //first get primary book language
     QString lang = GetPrimaryBookLanguage();
     QWriteLocker locker(&GetLock());
-    QString source = CleanSource::ProcessXML(GetText(),"application/oebps-package+xml");
-    OPFParser p;
-    p.parse(source);
+    OPFParser p = *GetParsedOPF();
     QString current_code = GetGuideSemanticCodeForResource(html_resource, p);
 
     if ((current_code != new_code) || !toggle) {
@@ -804,9 +781,8 @@ void OPFResource::SetGuideSemanticCodeForResource(QString code, const Resource *
 QString OPFResource::GetGuideSemanticCodeForResource(const Resource *resource) const
 {
     QReadLocker locker(&GetLock());
-    QString source = CleanSource::ProcessXML(GetText(),"application/oebps-package+xml");
-    OPFParser p;
-    p.parse(source);
+    QSharedPointer<const OPFParser> parsed = GetParsedOPF();
+    const OPFParser &p = *parsed;
     return GetGuideSemanticCodeForResource(resource, p);
 }
 
@@ -820,9 +796,8 @@ QString OPFResource::GetGuideSemanticNameForResource(Resource *resource)
 QHash <QString, QString>  OPFResource::GetSemanticCodeForPaths()
 {
   QReadLocker locker(&GetLock());
-  QString source = CleanSource::ProcessXML(GetText(),"application/oebps-package+xml");
-  OPFParser p;
-  p.parse(source);
+  QSharedPointer<const OPFParser> parsed = GetParsedOPF();
+  const OPFParser &p = *parsed;
 
   QHash <QString, QString> semantic_types;
   foreach(GuideEntry ge, p.m_guide) {
@@ -839,9 +814,8 @@ QHash <QString, QString>  OPFResource::GetSemanticCodeForPaths()
 QHash <QString, QString>  OPFResource::GetGuideSemanticNameForPaths()
 {
     QReadLocker locker(&GetLock());
-    QString source = CleanSource::ProcessXML(GetText(),"application/oebps-package+xml");
-    OPFParser p;
-    p.parse(source);
+    QSharedPointer<const OPFParser> parsed = GetParsedOPF();
+    const OPFParser &p = *parsed;
 
     QHash <QString, QString> semantic_types;
     foreach(GuideEntry ge, p.m_guide) {
@@ -869,9 +843,7 @@ QHash <QString, QString>  OPFResource::GetGuideSemanticNameForPaths()
 void OPFResource::SetResourceAsCoverImage(ImageResource *image_resource)
 {
     QWriteLocker locker(&GetLock());
-    QString source = CleanSource::ProcessXML(GetText(),"application/oebps-package+xml");
-    OPFParser p;
-    p.parse(source);
+    OPFParser p = *GetParsedOPF();
     QString resource_id = GetResourceManifestID(image_resource, p);
 
     // First deal with any previous covers by removing 
@@ -906,9 +878,7 @@ void OPFResource::SetResourceAsCoverImage(ImageResource *image_resource)
 void OPFResource::UpdateSpineOrder(const QList<::HTMLResource *> html_files)
 {
     QWriteLocker locker(&GetLock());
-    QString source = CleanSource::ProcessXML(GetText(),"application/oebps-package+xml");
-    OPFParser p;
-    p.parse(source);
+    OPFParser p = *GetParsedOPF();
     QList<SpineEntry> new_spine;
     foreach(HTMLResource * html_resource, html_files) {
         const Resource *resource = static_cast<const Resource *>(html_resource);
@@ -938,9 +908,7 @@ void OPFResource::UpdateSpineOrder(const QList<::HTMLResource *> html_files)
 void OPFResource::ResourceRenamed(const Resource *resource, QString old_full_path)
 {
     QWriteLocker locker(&GetLock());
-    QString source = CleanSource::ProcessXML(GetText(),"application/oebps-package+xml");
-    OPFParser p;
-    p.parse(source);
+    OPFParser p = *GetParsedOPF();
     // first convert old_full_path to old_bkpath
     QString old_bkpath = old_full_path.right(old_full_path.length() - GetFullPathToBookFolder().length() - 1);
     QString old_href = Utility::buildRelativePath(GetRelativePath(), old_bkpath);
@@ -996,9 +964,7 @@ void OPFResource::ResourceRenamed(const Resource *resource, QString old_full_pat
 void OPFResource::ResourceMoved(const Resource *resource, QString old_full_path)
 {
     QWriteLocker locker(&GetLock());
-    QString source = CleanSource::ProcessXML(GetText(),"application/oebps-package+xml");
-    OPFParser p;
-    p.parse(source);
+    OPFParser p = *GetParsedOPF();
     // first convert old_full_path to old_bkpath
     QString old_bkpath = old_full_path.right(old_full_path.length() - GetFullPathToBookFolder().length() - 1);
     QString old_href = Utility::buildRelativePath(GetRelativePath(), old_bkpath);
@@ -1145,9 +1111,7 @@ void OPFResource::WriteIdentifier(const QString &metaname, const QString &metava
 void OPFResource::AddModificationDateMeta()
 {
     QWriteLocker locker(&GetLock());
-    QString source = CleanSource::ProcessXML(GetText(),"application/oebps-package+xml");
-    OPFParser p;
-    p.parse(source);
+    OPFParser p = *GetParsedOPF();
 
     QString epubversion = GetEpubVersion();
     if (epubversion.startsWith('3')) {
@@ -1266,7 +1230,38 @@ QString OPFResource::GetFileMimetype(const QString &filepath) const
 
 void OPFResource::UpdateText(const OPFParser &p)
 {
-    TextResource::SetText(p.convert_to_xml());
+    QString source = p.convert_to_xml();
+    TextResource::SetText(source);
+    // The edited model already describes the new text so keep it
+    // as the cached model instead of parsing the text all over again.
+    // The position hashes are rebuilt in case an edit reordered the manifest.
+    OPFParser *parsed = new OPFParser(p);
+    parsed->m_idpos.clear();
+    parsed->m_hrefpos.clear();
+    for (int i = 0; i < parsed->m_manifest.count(); ++i) {
+        parsed->m_idpos[parsed->m_manifest.at(i).m_id] = i;
+        parsed->m_hrefpos[parsed->m_manifest.at(i).m_href] = i;
+    }
+    QMutexLocker cache_locker(&m_ParsedOPFMutex);
+    m_ParsedOPF = QSharedPointer<const OPFParser>(parsed);
+    m_ParsedOPFText = source;
+}
+
+
+QSharedPointer<const OPFParser> OPFResource::GetParsedOPF() const
+{
+    QString text = GetText();
+    QMutexLocker cache_locker(&m_ParsedOPFMutex);
+    // The text itself is the revision key. Comparing it is a memcmp at worst
+    // (and free while the string is still shared with the cache) which is
+    // nothing next to a trip through the python opf parser.
+    if (m_ParsedOPF.isNull() || (text != m_ParsedOPFText)) {
+        OPFParser *parsed = new OPFParser();
+        parsed->parse(CleanSource::ProcessXML(text,"application/oebps-package+xml"));
+        m_ParsedOPF = QSharedPointer<const OPFParser>(parsed);
+        m_ParsedOPFText = text;
+    }
+    return m_ParsedOPF;
 }
 
 
@@ -1294,9 +1289,7 @@ QString OPFResource::ValidatePackageVersion(const QString& source)
 void OPFResource::UpdateManifestProperties(const QList<Resource*> resources)
 {
     QWriteLocker locker(&GetLock());
-    QString source = CleanSource::ProcessXML(GetText(),"application/oebps-package+xml");
-    OPFParser p;
-    p.parse(source);
+    OPFParser p = *GetParsedOPF();
     if (p.m_package.m_version != "3.0") {
         return;
     }
@@ -1341,9 +1334,8 @@ QString OPFResource::GetManifestPropertiesForResource(const Resource * resource)
     QString properties;
     if (!resource) return properties;
     QReadLocker locker(&GetLock());
-    QString source = CleanSource::ProcessXML(GetText(),"application/oebps-package+xml");
-    OPFParser p;
-    p.parse(source);
+    QSharedPointer<const OPFParser> parsed = GetParsedOPF();
+    const OPFParser &p = *parsed;
     if (!p.m_package.m_version.startsWith("3")) {
         return properties;
     }
@@ -1365,9 +1357,8 @@ QHash <QString, QString>  OPFResource::GetManifestPropertiesForPaths()
         return manifest_properties_all;
     }
     QReadLocker locker(&GetLock());
-    QString source = CleanSource::ProcessXML(GetText(),"application/oebps-package+xml");
-    OPFParser p;
-    p.parse(source);
+    QSharedPointer<const OPFParser> parsed = GetParsedOPF();
+    const OPFParser &p = *parsed;
     foreach(ManifestEntry me, p.m_manifest) {
         QString href = me.m_href;
         if (me.m_atts.contains("properties")){
@@ -1392,9 +1383,7 @@ void OPFResource::SetNavResource(HTMLResource * nav_resource)
     // Make sure the proper nav property is set in the opf manifest
     if (m_NavResource) { 
         QWriteLocker locker(&GetLock());
-        QString source = CleanSource::ProcessXML(GetText(),"application/oebps-package+xml");
-        OPFParser p;
-        p.parse(source);
+        OPFParser p = *GetParsedOPF();
         QString href = GetRelativePathToResource(m_NavResource);
         int pos = p.m_hrefpos.value(href, -1);
         if ((pos >= 0) && (pos < p.m_manifest.count())) {
@@ -1410,9 +1399,7 @@ void OPFResource::SetNavResource(HTMLResource * nav_resource)
 void OPFResource::SetItemRefLinear(Resource * resource, bool linear)
 {
     QWriteLocker locker(&GetLock());
-    QString source = CleanSource::ProcessXML(GetText(),"application/oebps-package+xml");
-    OPFParser p;
-    p.parse(source);
+    OPFParser p = *GetParsedOPF();
     QString resource_href_path = GetRelativePathToResource(resource);
     int pos = p.m_hrefpos.value(resource_href_path, -1);
     QString item_id = "";
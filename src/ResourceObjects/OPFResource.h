@@ -26,9 +26,12 @@
 #define OPFRESOURCE_H
 
 #include <memory>
+#include <QtCore/QMutex>
+#include <QtCore/QSharedPointer>
 #include "Misc/GuideItems.h"
 #include "ResourceObjects/XMLResource.h"
 #include "ResourceObjects/OPFParser.h"
+#include "ResourceObjects/MetadataProcessor.h"
 
 class HTMLResource;
 class ImageResource;
@@ -131,6 +134,11 @@ public:
      */
     QList<QVariant> GetDCMetadataValues(QString text) const;
 
+    /**
+     * Returns the metadata split up for the Metadata Editor.
+     */
+    MetadataPieces GetMetadataPieces() const;
+
     void SetNavResource(HTMLResource* nav);
     HTMLResource* GetNavResource() const;
 
@@ -243,8 +251,22 @@ private:
 
     QString GetFileMimetype(const QString &filepath) const;
 
+    /**
+     * Serializes the model into the OPF text and keeps
+     * the model as the cached parse of that text.
+     */
     void UpdateText(const OPFParser &p);
 
+    /**
+     * Returns the parsed package model of the current OPF text.
+     * The model is cached and only reparsed when the text has changed
+     * since it was last parsed. Mutators copy it, edit the copy
+     * and hand it to UpdateText().
+     *
+     * @warning Make sure to hold the resource lock when calling this.
+     */
+    QSharedPointer<const OPFParser> GetParsedOPF() const;
+
     QString ValidatePackageVersion(const QString &source);
 
     ///////////////////////////////
@@ -253,6 +275,13 @@ private:
 
     HTMLResource * m_NavResource;
     bool m_WarnedAboutVersion;
+
+    /**
+     * The cached package model and the text it was parsed from.
+     */
+    mutable QSharedPointer<const OPFParser> m_ParsedOPF;
+    mutable QString m_ParsedOPFText;
+    mutable QMutex m_ParsedOPFMutex;
 };
 
 #endif // OPFRESOURCE_H
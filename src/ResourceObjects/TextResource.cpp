@@ -35,11 +35,9 @@ TextResource::TextResource(const QString &mainfolder, const QString &fullfilepat
     :
     Resource(mainfolder, fullfilepath, parent),
     m_CacheInUse(false),
-    m_TextDocument(new TextDocument(this)),
+    m_TextDocument(NULL),
     m_IsLoaded(false)
 {
-    m_TextDocument->setDocumentLayout(new QPlainTextDocumentLayout(m_TextDocument));
-    connect(m_TextDocument, SIGNAL(contentsChanged()), this, SIGNAL(Modified()));
 }
 
 
@@ -51,7 +49,12 @@ QString TextResource::GetText() const
         return m_Cache;
     }
 
-    return m_TextDocument->toText();
+    // An open editor changes the document directly.
+    if (m_TextDocument) {
+        return m_TextDocument->toText();
+    }
+
+    return m_Text;
 }
 
 
@@ -84,11 +87,35 @@ void TextResource::SetText(const QString &text)
 
 TextDocument& TextResource::GetTextDocumentForWriting()
 {
-    Q_ASSERT(m_TextDocument);
+    if (!m_TextDocument) {
+        QMutexLocker locker(&m_CacheAccessMutex);
+        m_TextDocument = new TextDocument(this);
+        m_TextDocument->setDocumentLayout(new QPlainTextDocumentLayout(m_TextDocument));
+        m_TextDocument->setPlainText(m_CacheInUse ? m_Cache : m_Text);
+        m_TextDocument->setModified(false);
+        m_Text.clear();
+        connect(m_TextDocument, SIGNAL(contentsChanged()), this, SIGNAL(Modified()));
+    }
+
     return *m_TextDocument;
 }
 
 
+void TextResource::ReleaseTextDocument()
+{
+    if (!m_TextDocument) {
+        return;
+    }
+
+    QMutexLocker locker(&m_CacheAccessMutex);
+    m_Text = m_TextDocument->toText();
+    disconnect(m_TextDocument, 0, this, 0);
+    // The editor may still be processing events for the document.
+    m_TextDocument->deleteLater();
+    m_TextDocument = NULL;
+}
+
+
 void TextResource::SaveToDisk(bool book_wide_save)
 {
     {
@@ -116,7 +143,10 @@ void TextResource::SaveToDisk(bool book_wide_save)
         emit ResourceUpdatedOnDisk();
     }
 
-    m_TextDocument->setModified(false);
+    if (m_TextDocument) {
+        m_TextDocument->setModified(false);
+    }
+
     Resource::SaveToDisk(book_wide_save);
 }
 
@@ -144,9 +174,13 @@ void TextResource::InitialLoad()
       * it had been opened in a tab first.
       */
     QWriteLocker locker(&GetLock());
-    Q_ASSERT(m_TextDocument);
+    bool is_empty;
+    {
+        QMutexLocker cache_locker(&m_CacheAccessMutex);
+        is_empty = m_TextDocument ? m_TextDocument->isEmpty() : m_Text.isEmpty();
+    }
 
-    if (m_TextDocument->isEmpty() && QFile::exists(GetFullPath())) {
+    if (is_empty && QFile::exists(GetFullPath())) {
         SetText(Utility::ReadUnicodeTextFile(GetFullPath()));
     }
 }
@@ -181,25 +215,52 @@ bool TextResource::LoadFromDisk()
 
 void TextResource::DelayedUpdateToTextDocument()
 {
-    QMutexLocker locker(&m_CacheAccessMutex);
+    QString text;
+    {
+        QMutexLocker locker(&m_CacheAccessMutex);
 
-    if (!m_CacheInUse) {
-        return;
+        if (!m_CacheInUse) {
+            return;
+        }
+
+        text = m_Cache;
     }
 
-    SetTextInternal(m_Cache);
+    SetTextInternal(text);
 }
 
 
 void TextResource::SetTextInternal(const QString &text)
 {
-    m_TextDocument->setPlainText(text);
-    m_TextDocument->setModified(false);
-    // Our resource has now been loaded with some text
-    m_IsLoaded = true;
-    m_CacheInUse = false;
-    // Clear anything left in the cache
-    // m_Cache = "";
+    // Only the GUI thread creates or releases the document, so it can
+    // be changed outside the mutex. Its change signals reach slots that
+    // read the text again and must not find the mutex held.
+    if (m_TextDocument) {
+        m_TextDocument->setPlainText(text);
+        m_TextDocument->setModified(false);
+    }
+
+    bool notify;
+    {
+        // GetText() reads m_Text from other threads under this mutex.
+        QMutexLocker locker(&m_CacheAccessMutex);
+        notify = !m_TextDocument;
+
+        if (notify) {
+            m_Text = text;
+        }
+
+        // Our resource has now been loaded with some text
+        m_IsLoaded = true;
+        m_CacheInUse = false;
+        // Clear anything left in the cache
+        // m_Cache = "";
+    }
+
+    if (notify) {
+        // Nothing to lay out. The document would have signaled the change.
+        emit Modified();
+    }
 }
 
 bool TextResource::IsLoaded()
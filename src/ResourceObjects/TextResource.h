@@ -64,7 +64,11 @@ public:
 
     /**
      * Returns a reference to the QTextDocument that can be read and written to
-     * in consumers. If you need just read access, use GetTextDocumentForReading().
+     * in consumers. If you need just read access, use GetText().
+     *
+     * The text is only kept in a plain string until an editor needs it so
+     * the document is created on the first call. While the document exists
+     * it holds the text of the resource.
      *
      * @warning Make sure to get a write lock externally before calling this function!
      *
@@ -72,6 +76,13 @@ public:
      */
     TextDocument &GetTextDocumentForWriting();
 
+    /**
+     * Drops the QTextDocument once no editor is showing it anymore.
+     * The text is kept as a plain string again. Called by tabs when
+     * they are closed.
+     */
+    void ReleaseTextDocument();
+
     // inherited
     void SaveToDisk(bool book_wide_save = false);
 
@@ -101,7 +112,7 @@ private slots:
 private:
 
     /**
-     * Actually sets the text to m_TextDocument.
+     * Actually sets the text to m_TextDocument or m_Text.
      *
      * @param text The text to set.
      */
@@ -127,8 +138,14 @@ private:
      */
     mutable QMutex m_CacheAccessMutex;
 
+    /**
+     * The text of the resource when there is no m_TextDocument.
+     */
+    QString m_Text;
+
     /**
      * The syntax colored cache of the TextResource text content.
+     * Only created while an editor is showing the resource.
      */
     TextDocument *m_TextDocument;
 
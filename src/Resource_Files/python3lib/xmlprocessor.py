@@ -2,6 +2,7 @@
 
 import sys
 import os
+import traceback
 from sigil_bs4 import BeautifulSoup
 from sigil_bs4.builder._lxml import LXMLTreeBuilderForXML
 import re
@@ -201,60 +202,6 @@ def repairXML(data, mtype="", indent_chars="  "):
     return newdata
 
 
-# this is used after a xhtml file split to update hrefs in the ncx
-def anchorNCXUpdates(data, ncx_bookpath, originating_bookpath, keylist, valuelist):
-    data = _remove_xml_header(data)
-    # lxml on a Mac does not seem to handle full unicode properly, so encode as utf-8
-    data = data.encode('utf-8')
-    # rebuild serialized lookup dictionary
-    id_dict = {}
-    for i in range(0, len(keylist)):
-        id_dict[ keylist[i] ] = valuelist[i]
-    startdir = startingDir(ncx_bookpath)
-    xmlbuilder = LXMLTreeBuilderForXML(parser=None, empty_element_tags=ebook_xml_empty_tags)
-    soup = BeautifulSoup(data, features=None, from_encoding="utf-8", builder=xmlbuilder)
-    for tag in soup.find_all("content"):
-        if "src" in tag.attrs:
-            src = tag["src"]
-            if src.find(":") == -1:
-                parts = src.split('#')
-                ahref = unquoteurl(parts[0])
-                # convert this href to its target bookpath
-                target_bookpath = buildBookPath(ahref,startdir)
-                if (parts is not None) and (len(parts) > 1) and (target_bookpath == originating_bookpath) and (parts[1] != ""):
-                    fragment_id = parts[1]
-                    if fragment_id in id_dict:
-                        target_bookpath = id_dict[fragment_id]
-                        attribute_value = buildRelativePath(ncx_bookpath, target_bookpath) + "#" + fragment_id
-                        tag["src"] = quoteurl(attribute_value)
-    newdata = soup.decodexml(indent_level=0, formatter='minimal', indent_chars="  ")
-    return newdata
-
-
-def anchorNCXUpdatesAfterMerge(data, ncx_bookpath, sink_bookpath, merged_bookpaths):
-    data = _remove_xml_header(data)
-    startdir = startingDir(ncx_bookpath)
-    # lxml on a Mac does not seem to handle full unicode properly, so encode as utf-8
-    data = data.encode('utf-8')
-    xmlbuilder = LXMLTreeBuilderForXML(parser=None, empty_element_tags=ebook_xml_empty_tags)
-    soup = BeautifulSoup(data, features=None, from_encoding="utf-8", builder=xmlbuilder)
-    for tag in soup.find_all("content"):
-        if "src" in tag.attrs:
-            src = tag["src"]
-            if src.find(":") == -1:
-                parts = src.split('#')
-                if parts is not None:
-                    ahref = unquoteurl(parts[0])
-                    target_bookpath = buildBookPath(ahref, startdir)
-                    if target_bookpath in merged_bookpaths:
-                        attribute_value = buildRelativePath(ncx_bookpath, sink_bookpath)
-                        if len(parts) > 1 and parts[1] != "":
-                            attribute_value += "#" + parts[1]
-                        tag["src"] = quoteurl(attribute_value)
-    newdata = soup.decodexml(indent_level=0, formatter='minimal', indent_chars="  ")
-    return newdata
-
-
 def performNCXSourceUpdates(data, newbkpath, oldbkpath, keylist, valuelist):
     data = _remove_xml_header(data)
     # lxml on a Mac does not seem to handle full unicode properly, so encode as utf-8
@@ -384,6 +331,34 @@ def performPageMapUpdates(data, newbkpath, oldbkpath, keylist, valuelist):
     return newdata
 
 
+# batch form of the routines above so that all of the smil and page-map
+# files of a book are updated with a single call into the interpreter
+# sources of any other media type are returned unchanged
+def performXMLUpdatesBatch(datalist, mtypelist, newbkpathlist, oldbkpathlist, keylist, valuelist):
+    routines = {
+        "application/smil+xml" : performSMILUpdates,
+        "application/oebps-page-map+xml" : performPageMapUpdates,
+        "application/vnd.adobe-page-map+xml" : performPageMapUpdates,
+    }
+    # returns the updated sources and, for each, the traceback if it failed
+    results = []
+    errors = []
+    for i in range(0, len(datalist)):
+        routine = routines.get(mtypelist[i], None)
+        if routine is None:
+            results.append(datalist[i])
+            errors.append("")
+            continue
+        try:
+            results.append(routine(datalist[i], newbkpathlist[i], oldbkpathlist[i], keylist, valuelist))
+            errors.append("")
+        except Exception:
+            # leave this file unchanged and carry on with the rest
+            results.append(datalist[i])
+            errors.append(traceback.format_exc())
+    return [results, errors]
+
+
 def main():
     argv = sys.argv
     opfxml = '''
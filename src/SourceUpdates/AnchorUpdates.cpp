@@ -23,7 +23,6 @@
 #include <memory>
 #include <functional>
 
-#include "Misc/EmbeddedPython.h"
 #include <QtCore/QtCore>
 #include <QtCore/QString>
 #include <QtCore/QHash>
@@ -248,40 +247,16 @@ void AnchorUpdates::UpdateTOCEntries(NCXResource *ncx_resource, const QString &o
     // this routine should only be run on epub2
     Q_ASSERT(ncx_resource);
     const QHash<QString, QString> &ID_locations = GetIDLocations(new_files);
-    // serialize the hash for passing to python
-    QStringList dictkeys = ID_locations.keys();
-    QStringList dictvals;
-    foreach(QString key, dictkeys) {
-      dictvals.append(ID_locations.value(key));
-    }
     QWriteLocker locker(&ncx_resource->GetLock());
-    QString source = ncx_resource->GetText();
     QString ncx_bookpath = ncx_resource->GetRelativePath();
-
-    int rv = 0;
-    QString error_traceback;
-
-    QList<QVariant> args;
-    args.append(QVariant(source));
-    args.append(QVariant(ncx_bookpath));
-    args.append(QVariant(originating_bookpath));
-    args.append(QVariant(dictkeys));
-    args.append(QVariant(dictvals));
-
-    EmbeddedPython * epython  = EmbeddedPython::instance();
-
-    QVariant res = epython->runInPython( QString("xmlprocessor"),
-                                         QString("anchorNCXUpdates"),
-                                         args,
-                                         &rv,
-                                         error_traceback);    
-    if (rv != 0) {
-      Utility::DisplayStdWarningDialog(QString("error in xmlprocessor anchorNCXUpdates: ") + QString::number(rv), 
-                                       error_traceback);
-      // an error happened - make no changes
-      return;
-    }
-    ncx_resource->SetText(res.toString());
+    QString source = RewriteNCXContentSrcs(ncx_resource->GetText(), ncx_bookpath,
+        [&](const QString &target_bookpath, const QString &fragment) -> QString {
+            if ((target_bookpath != originating_bookpath) || fragment.isEmpty() || !ID_locations.contains(fragment)) {
+                return QString();
+            }
+            return Utility::buildRelativePath(ncx_bookpath, ID_locations.value(fragment)) + "#" + fragment;
+        });
+    ncx_resource->SetText(source);
 }
 
 
@@ -292,31 +267,65 @@ void AnchorUpdates::UpdateTOCEntriesAfterMerge(NCXResource *ncx_resource, const
     // this routine should only be run on epub2
     Q_ASSERT(ncx_resource);
     QWriteLocker locker(&ncx_resource->GetLock());
-    QString source = ncx_resource->GetText();
     QString ncx_bookpath = ncx_resource->GetRelativePath();
+    QString source = RewriteNCXContentSrcs(ncx_resource->GetText(), ncx_bookpath,
+        [&](const QString &target_bookpath, const QString &fragment) -> QString {
+            if (!merged_bookpaths.contains(target_bookpath)) {
+                return QString();
+            }
+            QString href = Utility::buildRelativePath(ncx_bookpath, sink_bookpath);
+            if (!fragment.isEmpty()) {
+                href = href + "#" + fragment;
+            }
+            return href;
+        });
+    ncx_resource->SetText(source);
+}
 
-    int rv = 0;
-    QString error_traceback;
-
-    QList<QVariant> args;
-    args.append(QVariant(source));
-    args.append(QVariant(ncx_bookpath));
-    args.append(QVariant(sink_bookpath));
-    args.append(QVariant(merged_bookpaths));
-
-    EmbeddedPython * epython  = EmbeddedPython::instance();
-
-    QVariant res = epython->runInPython( QString("xmlprocessor"),
-                                         QString("anchorNCXUpdatesAfterMerge"),
-                                         args,
-                                         &rv,
-                                         error_traceback);    
-    if (rv != 0) {
-      Utility::DisplayStdWarningDialog(QString("error in xmlprocessor anchorNCXUpdatesAfterMerge: ") + QString::number(rv), 
-                                       error_traceback);
-      // an error happened - make no changes
-      return;
+
+// Only the src values of the <content> tags are replaced, everything else
+// in the ncx is kept exactly as it was. This used to be done by parsing and
+// reserializing the whole ncx in python, which took seconds for large tocs.
+QString AnchorUpdates::RewriteNCXContentSrcs(const QString &source, const QString &ncx_bookpath,
+                                             const std::function<QString(const QString &, const QString &)> &new_href)
+{
+    // comments are matched as well so that content tags inside them are skipped
+    static const QRegularExpression content_src("<!--.*?-->|<\\s*content\\b[^>]*?\\ssrc\\s*=\\s*(?:\"([^\"]*)\"|'([^']*)')",
+                                                QRegularExpression::CaseInsensitiveOption |
+                                                QRegularExpression::DotMatchesEverythingOption);
+    QString startdir = Utility::startingDir(ncx_bookpath);
+    QString result;
+    int last = 0;
+    QRegularExpressionMatchIterator mi = content_src.globalMatch(source);
+    while (mi.hasNext()) {
+        QRegularExpressionMatch mo = mi.next();
+        if (mo.capturedStart(1) == -1 && mo.capturedStart(2) == -1) {
+            continue;
+        }
+        int group = mo.capturedStart(1) != -1 ? 1 : 2;
+        // the raw attribute value, so entities must go before the '#' split
+        QString src = Utility::DecodeXML(mo.captured(group));
+        if (src.indexOf(":") != -1) {
+            continue;
+        }
+        QStringList parts = src.split('#', QString::KeepEmptyParts);
+        QString target_bookpath = Utility::buildBookPath(Utility::URLDecodePath(parts.at(0)), startdir);
+        QString fragment;
+        if (parts.size() > 1) {
+            fragment = parts.at(1);
+        }
+        QString href = new_href(target_bookpath, fragment);
+        if (href.isEmpty()) {
+            continue;
+        }
+        result.append(source.midRef(last, mo.capturedStart(group) - last));
+        result.append(Utility::URLEncodePath(href));
+        last = mo.capturedEnd(group);
+    }
+    if (last == 0) {
+        return source;
     }
-    ncx_resource->SetText(res.toString());
+    result.append(source.midRef(last));
+    return result;
 }
 
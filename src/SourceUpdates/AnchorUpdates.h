@@ -23,6 +23,8 @@
 #ifndef ANCHORUPDATES_H
 #define ANCHORUPDATES_H
 
+#include <functional>
+
 class HTMLResource;
 class NCXResource;
 
@@ -68,6 +70,14 @@ public:
 
 private:
 
+    /**
+     * Replaces the src of each relative <content> tag in the ncx source for which
+     * new_href, given the book path and fragment the src points to, returns a
+     * non-empty href (relative to the ncx). Returns the updated source.
+     */
+    static QString RewriteNCXContentSrcs(const QString &source, const QString &ncx_bookpath,
+                                         const std::function<QString(const QString &, const QString &)> &new_href);
+
     static QHash<QString, QString> GetIDLocations(const QList<HTMLResource *> &html_resources);
 
     static std::tuple<QString, QList<QString>> GetOneFileIDs(HTMLResource *html_resource);
@@ -30,79 +30,36 @@
 #include "sigil_constants.h"
 
 
-PerformXMLUpdates::PerformXMLUpdates(const QString &source,
-				     const QString &newbookpath,
-                                     const QHash<QString, QString> &xml_updates,
-                                     const QString &currentpath,
-                                     const QString &mtype)
-    :
-    m_Source(source),
-    m_XMLUpdates(xml_updates),
-    m_CurrentPath(currentpath),
-    m_MediaType(mtype),
-    m_newbookpath(newbookpath)
+QFuture<QVariant> PerformXMLUpdates::PerformBatchUpdates(const QStringList &sources,
+                                                         const QStringList &newbookpaths,
+                                                         const QStringList &currentpaths,
+                                                         const QStringList &mtypes,
+                                                         const QHash<QString, QString> &xml_updates)
 {
-}
-
-
-QString PerformXMLUpdates::operator()()
-{
-    QString newsource = m_Source;
+    // MISC_XML_MIMETYPES is defined in BookManipulation/FolderKeeper.cpp and sigil_constants.h
+    foreach(QString mtype, mtypes) {
+        if (!MISC_XML_MIMETYPES.contains(mtype)) {
+            // Utterly unsupported XML mimetypes, python leaves them unchanged
+            Utility::DisplayStdWarningDialog(QString("Unsupported XML media-type: ") + mtype); 
+        }
+    }
 
     // serialize the hash for passing to python
-    QStringList dictkeys = m_XMLUpdates.keys();
+    QStringList dictkeys = xml_updates.keys();
     QStringList dictvals;
     foreach(QString key, dictkeys) {
-        dictvals.append(m_XMLUpdates.value(key));
+        dictvals.append(xml_updates.value(key));
     }
 
-    int rv = 0;
-    QString error_traceback;
-
     QList<QVariant> args;
-    args.append(QVariant(newsource));
-    args.append(QVariant(m_newbookpath));
-    args.append(QVariant(m_CurrentPath));
+    args.append(QVariant(sources));
+    args.append(QVariant(mtypes));
+    args.append(QVariant(newbookpaths));
+    args.append(QVariant(currentpaths));
     args.append(QVariant(dictkeys));
     args.append(QVariant(dictvals));
 
-    QString routine;
-
-    // MISC_XML_MIMETYPES is defined in BookManipulation/FolderKeeper.cpp and sigil_constants.h
-    if (MISC_XML_MIMETYPES.contains(m_MediaType)) {
-        if (m_MediaType == "application/smil+xml") {
-            routine = "performSMILUpdates";
-        } else if ((m_MediaType == "application/oebps-page-map+xml") || 
-		   (m_MediaType == "application/vnd.adobe-page-map+xml"))  {
-            routine = "performPageMapUpdates";
-        } else {
-            // We allow editing, but currently have no python parsing/repair/link-updating routines. 
-	    // Make no changes.
-            // application/adobe-page-template+xml, application/vnd.adobe-page-template+xml, "application/pls+xml"
-            return newsource;
-        }
-    // Utterly unsupported XML mimetypes
-    } else {
-        Utility::DisplayStdWarningDialog(QString("Unsupported XML media-type: ") + m_MediaType); 
-        // make no changes
-        return newsource;
-    }
-
     EmbeddedPython * epython  = EmbeddedPython::instance();
 
-    QVariant res = epython->runInPython( QString("xmlprocessor"),
-                                         routine,
-                                         args,
-                                         &rv,
-                                         error_traceback);    
-    if (rv != 0) {
-        Utility::DisplayStdWarningDialog(QString("error in xmlprocessor performXMLUpdates: ") + QString::number(rv), 
-                                     error_traceback);
-        // an error happened - make no changes
-        return newsource;
-    }
-
-    return res.toString();
+    return epython->runInPythonAsync(QString("xmlprocessor"), QString("performXMLUpdatesBatch"), args);
 }
-
-
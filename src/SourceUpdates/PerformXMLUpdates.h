@@ -24,8 +24,10 @@
 #ifndef PERFORMXMLUPDATES_H
 #define PERFORMXMLUPDATES_H
 
+#include <QtCore/QFuture>
 #include <QtCore/QHash>
 #include <QtCore/QStringList>
+#include <QtCore/QVariant>
 
 class QString;
 class QStringList;
@@ -38,22 +40,21 @@ class PerformXMLUpdates
 
 public:
 
-    PerformXMLUpdates(const QString &source,
-		      const QString &newbookpath,
-                      const QHash<QString, QString> &xml_updates,
-                      const QString& currentpath,
-                      const QString& mtype);
-
-
-    QString operator()();
-
-
-private:
-    const QString &m_Source;
-    const QHash<QString, QString> &m_XMLUpdates;
-    const QString &m_CurrentPath;
-    const QString &m_MediaType;
-    const QString &m_newbookpath;
+    /**
+     * Updates many xml files with a single call into python made on the
+     * python worker thread, so it runs alongside other work. Sources of
+     * media types without an update routine are returned unchanged.
+     *
+     * @return A future for a list of two string lists, the updated sources
+     *         and for each the python traceback if its update failed, both
+     *         in the order of sources. The result is invalid if the python
+     *         call itself failed.
+     */
+    static QFuture<QVariant> PerformBatchUpdates(const QStringList &sources,
+                                                 const QStringList &newbookpaths,
+                                                 const QStringList &currentpaths,
+                                                 const QStringList &mtypes,
+                                                 const QHash<QString, QString> &xml_updates);
 };
 
 #endif // PERFORMXMLUPDATES_H
@@ -52,8 +52,7 @@
 
 QStringList UniversalUpdates::PerformUniversalUpdates(bool resources_already_loaded,
         const QList<Resource *> &resources,
-        const QHash<QString, QString> &updates,
-        const QList<XMLResource *> &non_well_formed)
+        const QHash<QString, QString> &updates)
 {
     QStringList updatekeys = updates.keys();
     QHash<QString, QString> html_updates;
@@ -92,13 +91,31 @@ QStringList UniversalUpdates::PerformUniversalUpdates(bool resources_already_loa
         html_future = QtConcurrent::mapped(html_resources, std::bind(UpdateOneHTMLFile, std::placeholders::_1, html_updates, css_updates));
         css_future = QtConcurrent::map(css_resources,  std::bind(UpdateOneCSSFile,  std::placeholders::_1, css_updates));
     } else {
-        html_future = QtConcurrent::mapped(html_resources, std::bind(LoadAndUpdateOneHTMLFile, std::placeholders::_1, html_updates, css_updates, non_well_formed));
+        html_future = QtConcurrent::mapped(html_resources, std::bind(LoadAndUpdateOneHTMLFile, std::placeholders::_1, html_updates, css_updates));
         css_future = QtConcurrent::map(css_resources,  std::bind(LoadAndUpdateOneCSSFile,  std::placeholders::_1, css_updates));
     }
 
     sync.addFuture(html_future);
     sync.addFuture(css_future);
 
+    // All other xml resources (smil, page-map) are updated by one python
+    // call on the python worker thread while the html and css are being done
+    QStringList xml_sources;
+    QStringList xml_newbookpaths;
+    QStringList xml_currentpaths;
+    QStringList xml_mtypes;
+    foreach(XMLResource * xml_resource, xml_resources) {
+        xml_sources << Utility::ReadUnicodeTextFile(xml_resource->GetFullPath());
+        xml_newbookpaths << xml_resource->GetRelativePath();
+        xml_currentpaths << xml_resource->GetCurrentBookRelPath();
+        xml_mtypes << xml_resource->GetMediaType();
+    }
+    QFuture<QVariant> xml_future;
+    if (!xml_resources.isEmpty()) {
+        xml_future = PerformXMLUpdates::PerformBatchUpdates(xml_sources, xml_newbookpaths, xml_currentpaths,
+                                                            xml_mtypes, xml_updates);
+    }
+
     // We can't schedule these with QtConcurrent because they
     // will (indirectly) call QTextDocument::setPlainText, and if
     // a tab is open for the ncx/opf, then an event needs to be sent
@@ -109,16 +126,33 @@ QStringList UniversalUpdates::PerformUniversalUpdates(bool resources_already_loa
     }
     const QString opf_result = UpdateOPFFile(opf_resource, xml_updates);
 
-    // Handle other xml resources one by one since done in Embedded Python
-    foreach(XMLResource * xml_resource, xml_resources) {
-        QString mtype = xml_resource->GetMediaType();
-        QString currentpath = xml_resource->GetCurrentBookRelPath();
-	QString new_bookpath = xml_resource->GetRelativePath();
-        QString version = xml_resource->GetEpubVersion();
-        const QString &source = Utility::ReadUnicodeTextFile(xml_resource->GetFullPath());
-        xml_resource->SetText(PerformXMLUpdates(source, new_bookpath, xml_updates, currentpath, mtype)());
-        xml_resource->SetCurrentBookRelPath("");
-        xml_resource->SaveToDisk();
+    // The text has to be set here on the gui thread, see above
+    if (!xml_resources.isEmpty()) {
+        xml_future.waitForFinished();
+        QVariantList res = xml_future.result().toList();
+        QStringList xml_results;
+        QStringList xml_errors;
+        if (res.count() == 2) {
+            xml_results = res.at(0).toStringList();
+            xml_errors = res.at(1).toStringList();
+        }
+        if ((xml_results.count() != xml_sources.count()) || (xml_errors.count() != xml_sources.count())) {
+            // an error happened - make no changes
+            Utility::DisplayStdWarningDialog(QString("error in xmlprocessor performXMLUpdatesBatch"));
+            xml_results = xml_sources;
+            xml_errors = QStringList();
+        }
+        for (int i = 0; i < xml_resources.count(); ++i) {
+            XMLResource *xml_resource = xml_resources.at(i);
+            if (!xml_errors.isEmpty() && !xml_errors.at(i).isEmpty()) {
+                // python left this file unchanged
+                Utility::DisplayStdWarningDialog(QString("error in xmlprocessor performXMLUpdates: ") + xml_newbookpaths.at(i),
+                                                 xml_errors.at(i));
+            }
+            xml_resource->SetText(xml_results.at(i));
+            xml_resource->SetCurrentBookRelPath("");
+            xml_resource->SaveToDisk();
+        }
     }
 
     sync.waitForFinished();
@@ -230,8 +264,7 @@ void UniversalUpdates::UpdateOneCSSFile(CSSResource *css_resource,
 
 QString UniversalUpdates::LoadAndUpdateOneHTMLFile(HTMLResource *html_resource,
         const QHash<QString, QString> &html_updates,
-        const QHash<QString, QString> &css_updates,
-        const QList<XMLResource *> &non_well_formed)
+        const QHash<QString, QString> &css_updates)
 {
     SettingsStore ss;
     QString source;
@@ -244,12 +277,6 @@ QString UniversalUpdates::LoadAndUpdateOneHTMLFile(HTMLResource *html_resource,
     QString newbookpath = html_resource->GetRelativePath();
     QString version = html_resource->GetEpubVersion();
 
-    // non_well_formed will only be set if the user has chosen not to have
-    // the file auto fixed.
-    if (non_well_formed.contains(html_resource)) {
-        return QString("%1: %2").arg(NON_WELL_FORMED_MESSAGE).arg(html_resource->GetRelativePath());
-    }
-
     try {
         source = XhtmlDoc::ResolveCustomEntities(html_resource->GetText());
         source = CleanSource::CharToEntity(source, version);
@@ -39,8 +39,7 @@ public:
     // Returns a list of errors if any that occurred while loading.
     static QStringList PerformUniversalUpdates(bool resources_already_loaded,
             const QList<Resource *> &resources,
-            const QHash<QString, QString> &updates,
-            const QList<XMLResource *> &non_well_formed=QList<XMLResource *>());
+            const QHash<QString, QString> &updates);
 
     static std::tuple <QHash<QString, QString>,
            QHash<QString, QString>,
@@ -61,8 +60,7 @@ private:
 
     static QString LoadAndUpdateOneHTMLFile(HTMLResource *html_resource,
                                             const QHash<QString, QString> &html_updates,
-                                            const QHash<QString, QString> &css_updates,
-                                            const QList<XMLResource *> &non_well_formed=QList<XMLResource *>());
+                                            const QHash<QString, QString> &css_updates);
 
     static QString UpdateOPFFile(OPFResource *opf_resource,
                                  const QHash<QString, QString> &xml_updates);
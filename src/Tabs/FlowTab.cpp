@@ -116,6 +116,12 @@ FlowTab::~FlowTab()
         m_wCodeView = 0;
     }
 
+    // Nothing is showing the text anymore so the resource can go
+    // back to keeping it as a plain string.
+    if (!GetResourceWasDeleted()) {
+        m_HTMLResource->ReleaseTextDocument();
+    }
+
     m_HTMLResource = NULL;
 
 }
@@ -225,7 +231,9 @@ void FlowTab::SaveTabContent()
 {
     // In CV, the connection between QPlainTextEdit and the underlying QTextDocument
     //        means the resource already is "saved". We just need to reset modified state.
-    m_HTMLResource->GetTextDocumentForWriting().setModified(false);
+    if (m_wCodeView) {
+        m_HTMLResource->GetTextDocumentForWriting().setModified(false);
+    }
 }
 
 void FlowTab::ResourceModified()
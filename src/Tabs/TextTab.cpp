@@ -58,6 +58,12 @@ TextTab::~TextTab()
         delete m_wCodeView;
         m_wCodeView = 0;
     }
+
+    // Nothing is showing the text anymore so the resource can go
+    // back to keeping it as a plain string.
+    if (!GetResourceWasDeleted()) {
+        m_TextResource->ReleaseTextDocument();
+    }
 }
 
 
@@ -292,6 +298,7 @@ void TextTab::ConnectSignalsToSlots()
     connect(m_wCodeView, SIGNAL(OpenClipEditorRequest(ClipEditorModel::clipEntry *)), this, SIGNAL(OpenClipEditorRequest(ClipEditorModel::clipEntry *)));
     connect(m_wCodeView, SIGNAL(MarkSelectionRequest()),         this, SIGNAL(MarkSelectionRequest()));
     connect(m_wCodeView, SIGNAL(ClearMarkedTextRequest()),              this, SIGNAL(ClearMarkedTextRequest()));
+    connect(m_wCodeView, SIGNAL(ShowStatusMessageRequest(const QString &)), this, SIGNAL(ShowStatusMessageRequest(const QString &)));
 }
 
 
@@ -81,6 +81,7 @@ QString XMLTab::GetShortPathName()
 bool XMLTab::IsDataWellFormed()
 {
     XhtmlDoc::WellFormedError error = m_XMLResource->WellFormedErrorLocation();
+    CleanSource::ShowWellFormedCheckFailure(error);
     bool well_formed = error.line == -1;
 
     if (!well_formed) {
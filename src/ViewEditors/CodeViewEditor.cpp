@@ -50,10 +50,12 @@
 #include "Misc/CSSHighlighter.h"
 #include "Misc/SettingsStore.h"
 #include "Misc/SpellCheck.h"
+#include "Misc/TagSpanIndex.h"
 #include "Misc/TextDocument.h"
 #include "Misc/HTMLSpellCheck.h"
 #include "Misc/Utility.h"
 #include "PCRE/PCRECache.h"
+#include "PCRE/PCREReplaceAllBuilder.h"
 #include "ViewEditors/CodeViewEditor.h"
 #include "ViewEditors/LineNumberArea.h"
 #include "sigil_constants.h"
@@ -101,7 +103,9 @@ CodeViewEditor::CodeViewEditor(HighlighterType high_type, bool check_spelling, Q
     m_clipMapper(new QSignalMapper(this)),
     m_MarkedTextStart(-1),
     m_MarkedTextEnd(-1),
-    m_ReplacingInMarkedText(false)
+    m_ReplacingInMarkedText(false),
+    m_TagSpanIndexValid(false),
+    m_ReformatCSSWatcher(new QFutureWatcher<QVariant>(this))
 {
     if (high_type == CodeViewEditor::Highlight_XHTML) {
         m_Highlighter = new XHTMLHighlighter(check_spelling, this);
@@ -770,6 +774,16 @@ SPCRE::MatchInfo CodeViewEditor::GetMisspelledWord(const QString &text, int star
     return match_info;
 }
 
+const TagSpanIndex &CodeViewEditor::GetTagSpanIndex()
+{
+    if (!m_TagSpanIndexValid) {
+        m_TagSpanIndex = TagSpanIndex(toPlainText());
+        m_TagSpanIndexValid = true;
+    }
+
+    return m_TagSpanIndex;
+}
+
 bool CodeViewEditor::FindNext(const QString &search_regex,
                               Searchable::Direction search_direction,
                               bool misspelled_words,
@@ -778,12 +792,8 @@ bool CodeViewEditor::FindNext(const QString &search_regex,
 							  bool marked_text,
 							  bool exclude_html_tag)
 {
-    SPCRE *spcre = PCRECache::instance()->getObject(search_regex);
-	SPCRE *spcreTagStart = PCRECache::instance()->getObject(QString("<"));
-	SPCRE *spcreTagEnd = PCRECache::instance()->getObject(QString(">"));
+    QSharedPointer<SPCRE> spcre = PCRECache::instance()->getObject(search_regex);
     SPCRE::MatchInfo match_info;
-	SPCRE::MatchInfo match_info_tag_start_before, match_info_tag_end_before;
-	SPCRE::MatchInfo match_info_tag_start_after, match_info_tag_end_after;
     QString txt = toPlainText();
     int start_offset = 0;
     int start = 0;
@@ -823,20 +833,7 @@ bool CodeViewEditor::FindNext(const QString &search_regex,
     }
 
 	if (exclude_html_tag && match_info.offset.first != -1) {
-		if (search_direction == Searchable::Direction_Up) {
-			match_info_tag_start_after = spcreTagStart->getFirstMatchInfo(Utility::Substring(start + match_info.offset.second, end, toPlainText()));
-			match_info_tag_end_after = spcreTagEnd->getFirstMatchInfo(Utility::Substring(start + match_info.offset.second, end, toPlainText()));
-			match_info_tag_start_before = spcreTagStart->getLastMatchInfo(Utility::Substring(start, match_info.offset.first, toPlainText()));
-			match_info_tag_end_before = spcreTagEnd->getLastMatchInfo(Utility::Substring(start, match_info.offset.first, toPlainText()));
-		}
-		else {
-			match_info_tag_start_after = spcreTagStart->getFirstMatchInfo(Utility::Substring(selection_offset + match_info.offset.second, end, toPlainText()));
-			match_info_tag_end_after = spcreTagEnd->getFirstMatchInfo(Utility::Substring(selection_offset + match_info.offset.second, end, toPlainText()));
-			match_info_tag_start_before = spcreTagStart->getLastMatchInfo(Utility::Substring(start, selection_offset + match_info.offset.first, toPlainText()));
-			match_info_tag_end_before = spcreTagEnd->getLastMatchInfo(Utility::Substring(start, selection_offset + match_info.offset.first, toPlainText()));
-		}
-		if ((match_info_tag_start_before.offset.first != -1 && (match_info_tag_end_before.offset.first == -1 || (match_info_tag_end_before.offset.first != -1 && match_info_tag_end_before.offset.second < match_info_tag_start_before.offset.second))) &&
-			(match_info_tag_end_after.offset.first != -1 && (match_info_tag_start_after.offset.first == -1 || (match_info_tag_start_after.offset.first != -1 && match_info_tag_end_after.offset.second < match_info_tag_start_after.offset.second)))) {
+		if (GetTagSpanIndex().IsInsideTag(match_info.offset.first + start_offset, match_info.offset.second + start_offset, start, end)) {
 
 			//QTextCursor c = textCursor();
 			//bool moveResult = false;
@@ -879,11 +876,13 @@ bool CodeViewEditor::FindNext(const QString &search_regex,
 
 int CodeViewEditor::Count(const QString &search_regex, Searchable::Direction direction, bool wrap, bool marked_text, bool exclude_html_tag)
 {
-    SPCRE *spcre = PCRECache::instance()->getObject(search_regex);
+    QSharedPointer<SPCRE> spcre = PCRECache::instance()->getObject(search_regex);
     QString text= toPlainText();
     int start = 0;
     int end = text.length();
 	int count = 0;
+	// Where the searched text starts within the document.
+	int text_offset = 0;
 
     if (marked_text) {
         if (!MoveToMarkedText(direction, wrap)) {
@@ -895,33 +894,24 @@ int CodeViewEditor::Count(const QString &search_regex, Searchable::Direction dir
     if (!wrap) {
         if (direction == Searchable::Direction_Up) {
             text = Utility::Substring(start, textCursor().position(), text);
+            text_offset = start;
         } else {
             text = Utility::Substring(textCursor().position(), end, text);
+            text_offset = textCursor().position();
         }
     } else if (marked_text) {
         text = Utility::Substring(start, end, text);
+        text_offset = start;
     }
-	QList<SPCRE::MatchInfo> match_info = spcre->getEveryMatchInfo(text);
-	SPCRE *spcreTagStart = PCRECache::instance()->getObject(QString("<"));
-	SPCRE *spcreTagEnd = PCRECache::instance()->getObject(QString(">"));
-	SPCRE::MatchInfo match_info_tag_start_before, match_info_tag_end_before;
-	SPCRE::MatchInfo match_info_tag_start_after, match_info_tag_end_after;
 	if (exclude_html_tag) {
-		for (int i = match_info.count() - 1; i >= 0; i--) {
-			if (direction == Searchable::Direction_Up) {
-				match_info_tag_start_after = spcreTagStart->getFirstMatchInfo(Utility::Substring(match_info[i].offset.second, end, text));
-				match_info_tag_end_after = spcreTagEnd->getFirstMatchInfo(Utility::Substring(match_info[i].offset.second, end, text));
-				match_info_tag_start_before = spcreTagStart->getLastMatchInfo(Utility::Substring(start, match_info[i].offset.first, text));
-				match_info_tag_end_before = spcreTagEnd->getLastMatchInfo(Utility::Substring(start, match_info[i].offset.first, text));
-			}
-			else {
-				match_info_tag_start_after = spcreTagStart->getFirstMatchInfo(Utility::Substring(match_info[i].offset.second, end, text));
-				match_info_tag_end_after = spcreTagEnd->getFirstMatchInfo(Utility::Substring(match_info[i].offset.second, end, text));
-				match_info_tag_start_before = spcreTagStart->getLastMatchInfo(Utility::Substring(start, match_info[i].offset.first, text));
-				match_info_tag_end_before = spcreTagEnd->getLastMatchInfo(Utility::Substring(start, match_info[i].offset.first, text));
-			}
-			if ((match_info_tag_start_before.offset.first != -1 && (match_info_tag_end_before.offset.first == -1 || (match_info_tag_end_before.offset.first != -1 && match_info_tag_end_before.offset.second < match_info_tag_start_before.offset.second))) &&
-				(match_info_tag_end_after.offset.first != -1 && (match_info_tag_start_after.offset.first == -1 || (match_info_tag_start_after.offset.first != -1 && match_info_tag_end_after.offset.second < match_info_tag_start_after.offset.second)))) {
+		// Matches are relative to the (possibly restricted) text so translate
+		// them into document offsets for the cached index.
+		const TagSpanIndex &tag_index = GetTagSpanIndex();
+		SPCRE::MatchIterator it(*spcre, text);
+
+		while (it.next()) {
+			if (tag_index.IsInsideTag(it.start() + text_offset, it.end() + text_offset,
+			                          text_offset, text_offset + text.length())) {
 				continue;
 			}
 			count++;
@@ -929,21 +919,14 @@ int CodeViewEditor::Count(const QString &search_regex, Searchable::Direction dir
 		return count;
 	}
 
-	return spcre->getEveryMatchInfo(text).count();
+	return spcre->getMatchCount(text);
 }
 
 bool CodeViewEditor::ReplaceSelected(const QString &search_regex, const QString &replacement, Searchable::Direction direction, bool replace_current, bool exclude_html_tag)
 {
-    SPCRE *spcre = PCRECache::instance()->getObject(search_regex);
-	SPCRE *spcreTagStart = PCRECache::instance()->getObject(QString("<"));
-	SPCRE *spcreTagEnd = PCRECache::instance()->getObject(QString(">"));
-
-	SPCRE::MatchInfo match_info_tag_start_before, match_info_tag_end_before;
-	SPCRE::MatchInfo match_info_tag_start_after, match_info_tag_end_after;
+    QSharedPointer<SPCRE> spcre = PCRECache::instance()->getObject(search_regex);
     int selection_start = textCursor().selectionStart();
     int selection_end = textCursor().selectionEnd();
-	int start = 0;
-	int end = toPlainText().length();
 
     // It is only safe to do a replace if we have not changed the selection or find text
     // since we last did a Find.
@@ -953,24 +936,8 @@ bool CodeViewEditor::ReplaceSelected(const QString &search_regex, const QString
 
     // Convert to plain text or \s won't get newlines
     const QString &document_text = toPlainText();
-	if (exclude_html_tag) {
-		if (direction == Searchable::Direction_Up) {
-			match_info_tag_start_after = spcreTagStart->getFirstMatchInfo(Utility::Substring(selection_end, end, document_text));
-			match_info_tag_end_after = spcreTagEnd->getFirstMatchInfo(Utility::Substring(selection_end, end, document_text));
-			match_info_tag_start_before = spcreTagStart->getLastMatchInfo(Utility::Substring(start, selection_start, document_text));
-			match_info_tag_end_before = spcreTagEnd->getLastMatchInfo(Utility::Substring(start, selection_start, document_text));
-		}
-		else {
-			match_info_tag_start_after = spcreTagStart->getFirstMatchInfo(Utility::Substring(selection_end, end, document_text));
-			match_info_tag_end_after = spcreTagEnd->getFirstMatchInfo(Utility::Substring(selection_end, end, document_text));
-			match_info_tag_start_before = spcreTagStart->getLastMatchInfo(Utility::Substring(start, selection_start, document_text));
-			match_info_tag_end_before = spcreTagEnd->getLastMatchInfo(Utility::Substring(start, selection_start, document_text));
-		}
-		if ((match_info_tag_start_before.offset.first != -1 && (match_info_tag_end_before.offset.first == -1 || (match_info_tag_end_before.offset.first != -1 && match_info_tag_end_before.offset.second < match_info_tag_start_before.offset.second))) &&
-			(match_info_tag_end_after.offset.first != -1 && (match_info_tag_start_after.offset.first == -1 || (match_info_tag_start_after.offset.first != -1 && match_info_tag_end_after.offset.second < match_info_tag_start_after.offset.second)))) {
-
-			return false;
-		}
+	if (exclude_html_tag && GetTagSpanIndex().IsInsideTag(selection_start, selection_end)) {
+		return false;
 	}
 
     QString selected_text = Utility::Substring(selection_start, selection_end, document_text);
@@ -1039,8 +1006,8 @@ int CodeViewEditor::ReplaceAll(const QString &search_regex,
 {
     int count = 0;
     QString text = toPlainText();
-	int start = 0;
-	int end = text.length();
+	// Where the searched text starts within the document.
+	int text_offset = 0;
     int original_position = textCursor().position();
     int position = original_position;
     if (marked_text) {
@@ -1050,65 +1017,54 @@ int CodeViewEditor::ReplaceAll(const QString &search_regex,
         }
         // Restrict replace to the marked area.
         text = Utility::Substring(m_MarkedTextStart, m_MarkedTextEnd, text);
+        text_offset = m_MarkedTextStart;
         position = original_position - m_MarkedTextStart;
     }
     int marked_text_length = text.length();
 
-    SPCRE *spcre = PCRECache::instance()->getObject(search_regex);
+    QSharedPointer<SPCRE> spcre = PCRECache::instance()->getObject(search_regex);
     QList<SPCRE::MatchInfo> match_info = spcre->getEveryMatchInfo(text);
-	SPCRE *spcreTagStart = PCRECache::instance()->getObject(QString("<"));
-	SPCRE *spcreTagEnd = PCRECache::instance()->getObject(QString(">"));
-	SPCRE::MatchInfo match_info_tag_start_before, match_info_tag_end_before;
-	SPCRE::MatchInfo match_info_tag_start_after, match_info_tag_end_after;
-    // Run though all match offsets making the replacement in reverse order.
-    // This way changes in text length won't change the offsets as we make
-    // our changes.
-    for (int i = match_info.count() - 1; i >= 0; i--) {
-		if (exclude_html_tag) {
-			if (direction == Searchable::Direction_Up) {
-				match_info_tag_start_after = spcreTagStart->getFirstMatchInfo(Utility::Substring(match_info[i].offset.second, end, text));
-				match_info_tag_end_after = spcreTagEnd->getFirstMatchInfo(Utility::Substring(match_info[i].offset.second, end, text));
-				match_info_tag_start_before = spcreTagStart->getLastMatchInfo(Utility::Substring(start, match_info[i].offset.first, text));
-				match_info_tag_end_before = spcreTagEnd->getLastMatchInfo(Utility::Substring(start, match_info[i].offset.first, text));
-			}
-			else {
-				match_info_tag_start_after = spcreTagStart->getFirstMatchInfo(Utility::Substring(match_info[i].offset.second, end, text));
-				match_info_tag_end_after = spcreTagEnd->getFirstMatchInfo(Utility::Substring(match_info[i].offset.second, end, text));
-				match_info_tag_start_before = spcreTagStart->getLastMatchInfo(Utility::Substring(start, match_info[i].offset.first, text));
-				match_info_tag_end_before = spcreTagEnd->getLastMatchInfo(Utility::Substring(start, match_info[i].offset.first, text));
-			}
-			if ((match_info_tag_start_before.offset.first != -1 && (match_info_tag_end_before.offset.first == -1 || (match_info_tag_end_before.offset.first != -1 && match_info_tag_end_before.offset.second < match_info_tag_start_before.offset.second))) &&
-				(match_info_tag_end_after.offset.first != -1 && (match_info_tag_start_after.offset.first == -1 || (match_info_tag_start_after.offset.first != -1 && match_info_tag_end_after.offset.second < match_info_tag_start_after.offset.second)))) {
-				continue;
-			}
+    // The index is built for the unmodified document so it must be fetched
+    // before any replacement is made.
+    TagSpanIndex tag_index;
+    if (exclude_html_tag) {
+        tag_index = GetTagSpanIndex();
+    }
+    // Select the matches to replace and move them to their location in
+    // the document so the replacement can be made in a single pass over
+    // the full text.
+    QList<SPCRE::MatchInfo> to_replace;
+    foreach(SPCRE::MatchInfo match, match_info) {
+		if (exclude_html_tag &&
+		    tag_index.IsInsideTag(match.offset.first + text_offset, match.offset.second + text_offset,
+		                          text_offset, text_offset + marked_text_length)) {
+			continue;
 		}
-        QString replaced_text;
         if (!wrap) {
             if (direction == Searchable::Direction_Up) {
-                if (match_info.at(i).offset.first > position) {
+                if (match.offset.first > position) {
                     break;
                 }
-            } else { 
-                if (match_info.at(i).offset.second < position) {
-                    break;
+            } else {
+                if (match.offset.second < position) {
+                    continue;
                 }
             }
         }
 
-        bool replacement_made = spcre->replaceText(Utility::Substring(match_info.at(i).offset.first, match_info.at(i).offset.second, text), match_info.at(i).capture_groups_offsets, replacement, replaced_text);
-
-        if (replacement_made) {
-            // Replace the text.
-            text = text.replace(match_info.at(i).offset.first, match_info.at(i).offset.second - match_info.at(i).offset.first, replaced_text);
-            count++;
-        }
+        match.offset.first += text_offset;
+        match.offset.second += text_offset;
+        to_replace.append(match);
     }
+
+    QList<PCREReplaceAllBuilder::ChangeRange> changes;
+    PCREReplaceAllBuilder builder(*spcre, replacement);
+    QString document_text = marked_text ? toPlainText() : text;
+    count = builder.Build(document_text, to_replace, text, &changes);
+
     if (marked_text) {
-        // Merge the replaced marked text into the original text and adjust the marker.
-        QString replaced_text = toPlainText();
-        replaced_text.replace(m_MarkedTextStart, m_MarkedTextEnd - m_MarkedTextStart, text);
-        m_MarkedTextEnd += text.length() - marked_text_length;
-        text = replaced_text;
+        // Adjust the marker to the size of the replaced marked text.
+        m_MarkedTextEnd = PCREReplaceAllBuilder::MapPosition(changes, m_MarkedTextEnd);
     }
 
     QTextCursor cursor = textCursor();
@@ -1121,7 +1077,8 @@ int CodeViewEditor::ReplaceAll(const QString &search_regex,
     cursor.insertText(text);
     cursor.endEditBlock();
 
-    // Restore the cursor position
+    // Restore the cursor position, shifted by the replacements before it.
+    cursor_position = PCREReplaceAllBuilder::MapPosition(changes, cursor_position);
     cursor.setPosition(cursor_position);
     setTextCursor(cursor);
 
@@ -1447,6 +1404,8 @@ void CodeViewEditor::AddReformatCSSContextMenu(QMenu *menu)
     connect(singleLineCSSAction, SIGNAL(triggered()), this, SLOT(ReformatCSSSingleLineAction()));
     reformatCSSMenu->addAction(multiLineCSSAction);
     reformatCSSMenu->addAction(singleLineCSSAction);
+    // one reformat at a time, see ReformatCSS
+    reformatCSSMenu->setEnabled(!m_ReformatCSSWatcher->isRunning());
 
     if (!topAction) {
         menu->addMenu(reformatCSSMenu);
@@ -2014,6 +1973,7 @@ void CodeViewEditor::TextChangedFilter()
     }
 
     ResetLastFindMatch();
+    m_TagSpanIndexValid = false;
 
     if (m_isUndoAvailable) {
         emit FilteredTextChanged();
@@ -3515,10 +3475,30 @@ void CodeViewEditor::ApplyChangeToProperties(QList<CSSInfo::CSSProperty *> &css_
 
 void CodeViewEditor::ReformatCSS(bool multiple_line_format)
 {
-    const QString &original_text = toPlainText();
-    // Currently this feature is only enabled for CSS content, no inline HTML
-    CSSInfo css_info(original_text, true);
-    const QString &new_text = css_info.getReformattedCSSText(multiple_line_format);
+    if (m_ReformatCSSWatcher->isRunning()) {
+        emit ShowStatusMessageRequest(tr("The CSS is still being reformatted."));
+        return;
+    }
+
+    // Currently this feature is only enabled for CSS content, no inline HTML.
+    // The reformatter runs on the python worker so the editor stays responsive,
+    // ReformatCSSFinished applies its result.
+    m_ReformatCSSOriginalText = toPlainText();
+    m_ReformatCSSWatcher->setFuture(CSSInfo::reformatCSSTextAsync(m_ReformatCSSOriginalText, multiple_line_format));
+}
+
+void CodeViewEditor::ReformatCSSFinished()
+{
+    const QString original_text = m_ReformatCSSOriginalText;
+    m_ReformatCSSOriginalText.clear();
+    const QString &new_text = CSSInfo::reformattedCSSTextFromResult(original_text,
+                                                                    m_ReformatCSSWatcher->result());
+
+    // Text typed in the meantime would be lost, so keep it instead.
+    if (toPlainText() != original_text) {
+        emit ShowStatusMessageRequest(tr("Reformat CSS cancelled, the text was changed while it was being reformatted."));
+        return;
+    }
 
     if (original_text != new_text) {
         QTextCursor cursor = textCursor();
@@ -4020,4 +4000,5 @@ void CodeViewEditor::ConnectSignalsToSlots()
     connect(m_addDictMapper, SIGNAL(mapped(const QString &)), this, SLOT(addToUserDictionary(const QString &)));
     connect(m_ignoreSpellingMapper, SIGNAL(mapped(const QString &)), this, SLOT(ignoreWord(const QString &)));
     connect(m_clipMapper, SIGNAL(mapped(const QString &)), this, SLOT(PasteClipEntryFromName(const QString &)));
+    connect(m_ReformatCSSWatcher, SIGNAL(finished()), this, SLOT(ReformatCSSFinished()));
 }
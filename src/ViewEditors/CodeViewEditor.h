@@ -24,6 +24,7 @@
 #ifndef CODEVIEWEDITOR_H
 #define CODEVIEWEDITOR_H
 
+#include <QtCore/QFutureWatcher>
 #include <QtCore/QList>
 #include <QtCore/QStack>
 #include <QtWidgets/QPlainTextEdit>
@@ -33,6 +34,7 @@
 #include "Misc/CSSInfo.h"
 #include "Misc/PasteTarget.h"
 #include "Misc/SettingsStore.h"
+#include "Misc/TagSpanIndex.h"
 #include "Misc/Utility.h"
 #include "Misc/TextDocument.h"
 #include "MiscEditors/ClipEditorModel.h"
@@ -234,6 +236,11 @@ public:
 
     void UpdateDisplay();
 
+    /**
+     * The tag delimiter index for the current text.
+     */
+    const TagSpanIndex &GetTagSpanIndex();
+
     SPCRE::MatchInfo GetMisspelledWord(const QString &text,
                                        int start_offset,
                                        int end_offset,
@@ -512,6 +519,12 @@ private slots:
 
     void PasteClipEntryFromName(const QString &name);
 
+    /**
+     * Replaces the text with the result of ReformatCSS
+     * unless it was edited while the reformatter ran.
+     */
+    void ReformatCSSFinished();
+
     /**
      * Used solely to update the m_isUndoAvailable variable
      * on undo availability change.
@@ -848,6 +861,13 @@ private:
     SPCRE::MatchInfo m_lastMatch;
     QString m_lastFindRegex;
 
+    /**
+     * Tag delimiter index of the current text used when excluding
+     * matches inside of tags. Rebuilt lazily after the text changes.
+     */
+    TagSpanIndex m_TagSpanIndex;
+    bool m_TagSpanIndexValid;
+
     /**
      * Map spelling suggestion actions from the context menu to the
      * ReplaceSelected slot.
@@ -872,6 +892,13 @@ private:
      */
     bool m_pendingSpellingHighlighting;
     QString m_element_name;
+
+    /**
+     * Waits for the python worker to reformat the CSS
+     * and the text it was given, see ReformatCSS.
+     */
+    QFutureWatcher<QVariant> *m_ReformatCSSWatcher;
+    QString m_ReformatCSSOriginalText;
 };
 
 #endif // CODEVIEWEDITOR_H
@@ -552,7 +552,12 @@ int main(int argc, char *argv[])
             MainWindow *widget = GetMainWindow(arguments);
             widget->show();
             QApplication::setActiveWindow(widget);
-            return app.exec();
+            int rv = app.exec();
+            // set SIGIL_DEBUG_TIMING to see where the embedded interpreter time went this session
+            if (qEnvironmentVariableIsSet("SIGIL_DEBUG_TIMING")) {
+                qDebug().noquote() << epython->callStatisticsReport();
+            }
+            return rv;
         }
     } catch (std::exception &e) {
         Utility::DisplayExceptionErrorDialog(e.what());